@@ -0,0 +1,35 @@
+#pragma once
+#include <type_traits>
+
+#include ".\hrtds_integral.h"
+#include ".\hrtds_decimal.h"
+#include ".\hrtds_misc.h"
+
+namespace hrtds {
+	namespace data {
+		// Every built-in type, for the code which handles each of them
+		// with their C++ type (the JSON transcoder, columnar arrays, ...).
+		// 'function' is called with a std::type_identity<T> per type:
+		//
+		//	data::ForEachBuiltin([&](auto type) {
+		//		using T = typename decltype(type)::type;
+		//		table[StaticConverter<T>::Alias] = ...;
+		//	});
+		template<typename F>
+		void ForEachBuiltin(F&& function)
+		{
+			function(std::type_identity<int8_t>());
+			function(std::type_identity<int16_t>());
+			function(std::type_identity<int32_t>());
+			function(std::type_identity<int64_t>());
+			function(std::type_identity<uint8_t>());
+			function(std::type_identity<uint16_t>());
+			function(std::type_identity<uint32_t>());
+			function(std::type_identity<uint64_t>());
+			function(std::type_identity<float>());
+			function(std::type_identity<double>());
+			function(std::type_identity<bool>());
+			function(std::type_identity<std::string>());
+		}
+	}
+}
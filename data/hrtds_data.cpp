@@ -1,8 +1,119 @@
 #include ".\hrtds_data.h"
 
+#include <stdexcept>
+
+uint64_t hrtds::data::HashBytes(const void* bytes, size_t size, uint64_t seed)
+{
+	const unsigned char* current = static_cast<const unsigned char*>(bytes);
+	for (size_t i = 0; i < size; i++)
+	{
+		seed ^= current[i];
+		seed *= 1099511628211ull;
+	}
+
+	return seed;
+}
+
+uint64_t hrtds::data::HashCombine(uint64_t seed, uint64_t value)
+{
+	// boost::hash_combine widened to 64 bits, followed by the finalizer
+	// of splitmix64 so that every bit of the inputs spreads
+	uint64_t hash = seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 12) + (seed >> 4));
+	hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+	hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+	return hash ^ (hash >> 31);
+}
+
 void hrtds::data::DynamicConverter::Register(const std::string& key, FromStringFunction fromFunc, ToStringFunction toFunc, DestroyFunction destroyFunc)
 {
 	DynamicConverter::FromString[key] = fromFunc;
 	DynamicConverter::ToString[key] = toFunc;
 	DynamicConverter::Destroy[key] = destroyFunc;
 }
+
+void hrtds::data::DynamicConverter::Register(const std::string& key, FromStringFunction fromFunc, ToStringFunction toFunc, DestroyFunction destroyFunc, CopyFunction copyFunc)
+{
+	DynamicConverter::Register(key, fromFunc, toFunc, destroyFunc);
+	DynamicConverter::Copy[key] = copyFunc;
+}
+
+void* hrtds::data::DynamicConverter::Duplicate(const std::string& key, const void* data)
+{
+	auto it = DynamicConverter::Copy.find(key);
+	if (it != DynamicConverter::Copy.end()) {
+		return it->second(data);
+	}
+
+	// Fall back to a round trip through the string form
+	return DynamicConverter::FromString.at(key)(DynamicConverter::ToString.at(key)(data));
+}
+
+uint64_t hrtds::data::DynamicConverter::HashOf(const std::string& key, const void* data)
+{
+	auto it = DynamicConverter::Hash.find(key);
+	if (it != DynamicConverter::Hash.end()) {
+		return it->second(data);
+	}
+
+	std::string text = DynamicConverter::ToString.at(key)(data);
+	return HashBytes(text.data(), text.size());
+}
+
+void hrtds::data::DynamicConverter::Register(const std::string& key, const InPlaceConverter& converter)
+{
+	DynamicConverter::InPlace[key] = converter;
+}
+
+void* hrtds::data::DynamicConverter::FromText(const std::string& key, std::string_view text)
+{
+	auto it = DynamicConverter::InPlace.find(key);
+	if (it == DynamicConverter::InPlace.end()) {
+		return DynamicConverter::FromString.at(key)(std::string(text));
+	}
+
+	// Freed by the type's Destroy(..)
+	const InPlaceConverter& converter = it->second;
+	void* storage = InPlaceConverter::Allocate(converter.size, converter.alignment);
+	try {
+		converter.parse(text, storage);
+	}
+	catch (...) {
+		InPlaceConverter::Deallocate(storage, converter.alignment);
+		throw;
+	}
+
+	return storage;
+}
+
+void hrtds::data::DynamicConverter::ParseArray(const std::string& key, std::span<const std::string_view> texts, void* storage)
+{
+	auto it = DynamicConverter::InPlace.find(key);
+	if (it == DynamicConverter::InPlace.end()) {
+		throw std::invalid_argument("The type '" + key + "' has no in-place converter.");
+	}
+
+	const InPlaceConverter& converter = it->second;
+	if (converter.parseArray != nullptr) {
+		converter.parseArray(texts, storage);
+		return;
+	}
+
+	// One by one, undoing the elements already parsed if one fails
+	char* elements = static_cast<char*>(storage);
+	size_t parsed = 0;
+	try {
+		for (; parsed < texts.size(); parsed++)
+		{
+			converter.parse(texts[parsed], elements + parsed * converter.size);
+		}
+	}
+	catch (...) {
+		while (parsed > 0)
+		{
+			parsed--;
+			converter.destruct(elements + parsed * converter.size);
+		}
+
+		throw;
+	}
+}
@@ -1,6 +1,12 @@
 #pragma once
+#include <new>
+#include <span>
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <string_view>
+#include <typeindex>
+#include <type_traits>
 #include <unordered_map>
 
 namespace hrtds {
@@ -8,51 +14,264 @@ namespace hrtds {
 		template<typename T>
 		struct dependent_false : std::false_type {};
 
+		// Specializations also carry their in-file alias as
+		// 'static constexpr const char* Alias', which typed accessors such
+		// as hrtds::TypedFieldHandle<T> rely on
 		template<typename T>
 		struct StaticConverter {
 			static inline void* FromString(const std::string& input) {
 				static_assert(dependent_false<T>::value, "Converter<T>::FromString(const std::string&) is not implemented for type T.");
+				return nullptr;
 			}
 
 			static inline std::string ToString(const void* data) {
 				static_assert(dependent_false<T>::value, "Converter<T>::ToString(const std::string&) is not implemented for type T.");
+				return std::string();
 			}
 
 			static inline void Destroy(void* data) {
 				static_assert(dependent_false<T>::value, "Converter<T>::Destroy(void*) is not implemented for type T.");
 			}
+
+			static inline void* Copy(const void* data) {
+				static_assert(dependent_false<T>::value, "Converter<T>::Copy(const void*) is not implemented for type T.");
+				return nullptr;
+			}
 		private:
 			static inline bool _reg;
 		};
 
+		// The bytes the data of a value takes up, sizeof(T) unless T
+		// allocates more itself (like std::string, see hrtds_misc.h)
+		template<typename T>
+		struct MemorySize {
+			static size_t Of(const void*) {
+				return sizeof(T);
+			}
+		};
+
+		// The FNV-1a offset basis, what every hash starts from
+		inline constexpr uint64_t HASH_SEED = 14695981039346656037ull;
+
+		// FNV-1a over 'size' bytes, continuing from 'seed'
+		uint64_t HashBytes(const void* bytes, size_t size, uint64_t seed = HASH_SEED);
+
+		// Folds 'value' into 'seed', the order values are folded in matters
+		uint64_t HashCombine(uint64_t seed, uint64_t value);
+
+		// The hash of the data of a value, over the bytes of T for plain
+		// types without padding and over the text ToString(..) gives for
+		// every other type (see hrtds_misc.h for std::string)
+		template<typename T>
+		struct ContentHash {
+			static uint64_t Of(const void* data) {
+				if constexpr (std::is_trivially_copyable_v<T> && (std::has_unique_object_representations_v<T> || std::is_floating_point_v<T>)) {
+					return HashBytes(data, sizeof(T));
+				}
+				else {
+					std::string text = StaticConverter<T>::ToString(data);
+					return HashBytes(text.data(), text.size());
+				}
+			}
+		};
+
 
 #define HRTDS_DATA_STATIC_CONVERTER(Type, alias)						\
     template<>															\
     struct hrtds::data::StaticConverter<Type> {							\
+        static constexpr const char* Alias = alias;						\
         static void* FromString(const std::string&);					\
         static std::string ToString(const void*);								\
         static void Destroy(void*);										\
+        static void* Copy(const void* data) {							\
+            return new Type(*reinterpret_cast<const Type*>(data));		\
+        }																\
     private:															\
         static inline bool _reg = []{									\
             DynamicConverter::Register(									\
                 alias,													\
                 &StaticConverter<Type>::FromString,						\
                 &StaticConverter<Type>::ToString,						\
-                &StaticConverter<Type>::Destroy							\
+                &StaticConverter<Type>::Destroy,						\
+                &StaticConverter<Type>::Copy							\
             );															\
+            DynamicConverter::SizeOf[alias] = &MemorySize<Type>::Of;	\
+            DynamicConverter::Hash[alias] = &ContentHash<Type>::Of;		\
 																		\
             return true;												\
         }();															\
     };																	\
 
+#define HRTDS_DATA_INPLACE_CONVERTER(Type, alias)						\
+    template<>															\
+    struct hrtds::data::StaticConverter<Type> : hrtds::data::InPlaceAdapter<Type> {	\
+        static constexpr const char* Alias = alias;						\
+        static void Parse(std::string_view, void*);						\
+        static std::string ToString(const void*);						\
+    private:															\
+        static inline bool _reg = []{									\
+            InPlaceAdapter<Type>::Register(alias, nullptr);				\
+            return true;												\
+        }();															\
+    };																	\
+
+#define HRTDS_DATA_INPLACE_BATCH_CONVERTER(Type, alias)					\
+    template<>															\
+    struct hrtds::data::StaticConverter<Type> : hrtds::data::InPlaceAdapter<Type> {	\
+        static constexpr const char* Alias = alias;						\
+        static void Parse(std::string_view, void*);						\
+        static void ParseArray(std::span<const std::string_view>, void*);	\
+        static std::string ToString(const void*);						\
+    private:															\
+        static inline bool _reg = []{									\
+            InPlaceAdapter<Type>::Register(alias, &StaticConverter<Type>::ParseArray);	\
+            return true;												\
+        }();															\
+    };																	\
+
 		typedef void*(*FromStringFunction)(const std::string&);
 		typedef std::string(*ToStringFunction)(const void*);
 		typedef void(*DestroyFunction)(void*);
+		typedef void*(*CopyFunction)(const void*);
+
+		typedef void(*ParseFunction)(std::string_view, void*);
+		typedef void(*ParseArrayFunction)(std::span<const std::string_view>, void*);
+		typedef void(*DestructFunction)(void*);
+		typedef void(*CopyIntoFunction)(const void*, void*);
+
+		typedef size_t(*SizeOfFunction)(const void*);
+		typedef uint64_t(*HashFunction)(const void*);
+
+		// A type which is constructed into storage handed to it, rather than
+		// allocating itself
+		//
+		//	   storage:	 [ size | size | size | ... ]	(aligned to 'alignment')
+		//				   ^parse("1, 2")
+		//
+		// 'parse' constructs a value into uninitialized storage and
+		// 'destruct' ends its lifetime without freeing the storage.
+		// 'parseArray' is optional, it converts a whole array of texts
+		// into consecutive elements at once. When it throws, it must not
+		// leave any element constructed.
+		struct InPlaceConverter {
+			// Storage for a single value, obtained the way 'new T' obtains 
+			// it. A value constructed into it is freed with 'delete', just
+			// like one handed to hrtds::Value::Set(new T(..)).
+			static void* Allocate(size_t size, size_t alignment) {
+				if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) return ::operator new(size, std::align_val_t(alignment));
+				return ::operator new(size);
+			}
+
+			static void Deallocate(void* storage, size_t alignment) {
+				if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) ::operator delete(storage, std::align_val_t(alignment));
+				else ::operator delete(storage);
+			}
+
+			size_t size = 0;
+			size_t alignment = 0;
+			std::type_index type = typeid(void);
+
+			ParseFunction parse = nullptr;
+			ToStringFunction toString = nullptr;
+			DestructFunction destruct = nullptr;
+			CopyIntoFunction copy = nullptr;
+			ParseArrayFunction parseArray = nullptr;
+		};
+
 		struct DynamicConverter {
 			static inline std::unordered_map<std::string, FromStringFunction> FromString{};
 			static inline std::unordered_map<std::string, ToStringFunction> ToString{};
 			static inline std::unordered_map<std::string, DestroyFunction> Destroy{};
+
+			// Optional, types registered without one are copied through 
+			// ToString(..) and FromString(..) instead
+			static inline std::unordered_map<std::string, CopyFunction> Copy{};
+
+			// Optional, the bytes a value's data takes up (see MemorySize<T>).
+			// Types registered without one count as taking up nothing.
+			static inline std::unordered_map<std::string, SizeOfFunction> SizeOf{};
+
+			// Optional, the hash of a value's data (see ContentHash<T>). Types
+			// registered without one are hashed through ToString(..) instead.
+			static inline std::unordered_map<std::string, HashFunction> Hash{};
+
 			static void Register(const std::string& key, FromStringFunction fromFunc, ToStringFunction toFunc, DestroyFunction destroyFunc);
+			static void Register(const std::string& key, FromStringFunction fromFunc, ToStringFunction toFunc, DestroyFunction destroyFunc, CopyFunction copyFunc);
+
+			// Duplicates the data of a value with the identifier 'key'
+			static void* Duplicate(const std::string& key, const void* data);
+
+			// Hashes the data of a value with the identifier 'key'
+			static uint64_t HashOf(const std::string& key, const void* data);
+
+			// Types registered through HRTDS_DATA_INPLACE_CONVERTER(..). These
+			// are registered in the maps above as well, converting into heap
+			// storage, so every other part of the library handles them as usual.
+			static inline std::unordered_map<std::string, InPlaceConverter> InPlace{};
+
+			static void Register(const std::string& key, const InPlaceConverter& converter);
+
+			// The data of a value with the identifier 'key' converted from 
+			// 'text', like FromString[key](..). In-place types are parsed
+			// from the view directly, without building a std::string.
+			static void* FromText(const std::string& key, std::string_view text);
+
+			// Converts every text into consecutive elements of 'storage', 
+			// through the batch hook if the type has one. Only for in-place
+			// types, 'storage' has to hold texts.size() elements.
+			static void ParseArray(const std::string& key, std::span<const std::string_view> texts, void* storage);
+		};
+
+		// What HRTDS_DATA_INPLACE_CONVERTER(..) derives from, the heap 
+		// converters (and the rest of InPlaceConverter) in terms of
+		// StaticConverter<T>::Parse(..) and T's own constructors
+		template<typename T>
+		struct InPlaceAdapter {
+			static void* FromString(const std::string& input) {
+				void* storage = InPlaceConverter::Allocate(sizeof(T), alignof(T));
+				try {
+					StaticConverter<T>::Parse(input, storage);
+				}
+				catch (...) {
+					InPlaceConverter::Deallocate(storage, alignof(T));
+					throw;
+				}
+
+				return storage;
+			}
+
+			static void Destroy(void* data) {
+				delete static_cast<T*>(data);
+			}
+
+			static void* Copy(const void* data) {
+				return new T(*static_cast<const T*>(data));
+			}
+
+			static void Destruct(void* storage) {
+				static_cast<T*>(storage)->~T();
+			}
+
+			static void CopyInto(const void* data, void* storage) {
+				new (storage) T(*static_cast<const T*>(data));
+			}
+
+			static void Register(const std::string& key, ParseArrayFunction parseArray) {
+				DynamicConverter::Register(key, &FromString, &StaticConverter<T>::ToString, &Destroy, &Copy);
+				DynamicConverter::SizeOf[key] = &MemorySize<T>::Of;
+				DynamicConverter::Hash[key] = &ContentHash<T>::Of;
+
+				InPlaceConverter converter;
+				converter.size = sizeof(T);
+				converter.alignment = alignof(T);
+				converter.type = typeid(T);
+				converter.parse = &StaticConverter<T>::Parse;
+				converter.toString = &StaticConverter<T>::ToString;
+				converter.destruct = &Destruct;
+				converter.copy = &CopyInto;
+				converter.parseArray = parseArray;
+				DynamicConverter::Register(key, converter);
+			}
 		};
 
 	};
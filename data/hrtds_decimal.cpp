@@ -4,10 +4,7 @@
 
 void* hrtds::data::StaticConverter<float>::FromString(const std::string& input) 
 {
-	float* output = new float();
-	*output = std::stof(input);
-
-	return output;
+	return new float(std::stof(input));
 }
 
 std::string hrtds::data::StaticConverter<float>::ToString(const void* data) {
@@ -20,10 +17,7 @@ void hrtds::data::StaticConverter<float>::Destroy(void* data) {
 
 void* hrtds::data::StaticConverter<double>::FromString(const std::string& input) 
 {
-	double* output = new double();
-	*output = std::stod(input);
-
-	return output;
+	return new double(std::stod(input));
 }
 
 std::string hrtds::data::StaticConverter<double>::ToString(const void* data) {
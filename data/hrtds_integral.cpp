@@ -30,10 +30,7 @@ constexpr T saturate_cast(U value) {
 
 void* hrtds::data::StaticConverter<int8_t>::FromString(const std::string& input) 
 {
-	int8_t* output = new int8_t();
-	*output = saturate_cast<int8_t>(std::stoi(input));
-
-	return output;
+	return new int8_t(saturate_cast<int8_t>(std::stoi(input)));
 }
 
 std::string hrtds::data::StaticConverter<int8_t>::ToString(const void* data) 
@@ -48,10 +45,7 @@ void hrtds::data::StaticConverter<int8_t>::Destroy(void* data)
 
 void* hrtds::data::StaticConverter<int16_t>::FromString(const std::string& input)
 {
-	int16_t* output = new int16_t();
-	*output = saturate_cast<int16_t>(std::stoi(input));
-
-	return output;
+	return new int16_t(saturate_cast<int16_t>(std::stoi(input)));
 }
 
 std::string hrtds::data::StaticConverter<int16_t>::ToString(const void* data) 
@@ -66,10 +60,7 @@ void hrtds::data::StaticConverter<int16_t>::Destroy(void* data)
 
 void* hrtds::data::StaticConverter<int32_t>::FromString(const std::string& input)
 {
-	int32_t* output = new int32_t();
-	*output = saturate_cast<int32_t>(std::stol(input));
-
-	return output;
+	return new int32_t(saturate_cast<int32_t>(std::stol(input)));
 }
 
 std::string hrtds::data::StaticConverter<int32_t>::ToString(const void* data) 
@@ -84,10 +75,7 @@ void hrtds::data::StaticConverter<int32_t>::Destroy(void* data)
 
 void* hrtds::data::StaticConverter<int64_t>::FromString(const std::string& input)
 {
-	int64_t* output = new int64_t();
-	*output = saturate_cast<int64_t>(std::stoll(input));
-
-	return output;
+	return new int64_t(saturate_cast<int64_t>(std::stoll(input)));
 }
 
 std::string hrtds::data::StaticConverter<int64_t>::ToString(const void* data) 
@@ -102,10 +90,7 @@ void hrtds::data::StaticConverter<int64_t>::Destroy(void* data)
 
 void* hrtds::data::StaticConverter<uint8_t>::FromString(const std::string& input)
 {
-	uint8_t* output = new uint8_t();
-	*output = saturate_cast<uint8_t>(std::stoul(input));
-
-	return output;
+	return new uint8_t(saturate_cast<uint8_t>(std::stoul(input)));
 }
 
 std::string hrtds::data::StaticConverter<uint8_t>::ToString(const void* data) 
@@ -120,10 +105,7 @@ void hrtds::data::StaticConverter<uint8_t>::Destroy(void* data)
 
 void* hrtds::data::StaticConverter<uint16_t>::FromString(const std::string& input)
 {
-	uint16_t* output = new uint16_t();
-	*output = saturate_cast<uint16_t>(std::stoul(input));
-
-	return output;
+	return new uint16_t(saturate_cast<uint16_t>(std::stoul(input)));
 }
 
 std::string hrtds::data::StaticConverter<uint16_t>::ToString(const void* data) 
@@ -138,10 +120,7 @@ void hrtds::data::StaticConverter<uint16_t>::Destroy(void* data)
 
 void* hrtds::data::StaticConverter<uint32_t>::FromString(const std::string& input)
 {
-	uint32_t* output = new uint32_t();
-	*output = saturate_cast<uint32_t>(std::stoul(input));
-
-	return output;
+	return new uint32_t(saturate_cast<uint32_t>(std::stoul(input)));
 }
 
 std::string hrtds::data::StaticConverter<uint32_t>::ToString(const void* data) 
@@ -156,10 +135,7 @@ void hrtds::data::StaticConverter<uint32_t>::Destroy(void* data)
 
 void* hrtds::data::StaticConverter<uint64_t>::FromString(const std::string& input)
 {
-	uint64_t* output = new uint64_t();
-	*output = saturate_cast<uint64_t>(std::stoull(input));
-
-	return output;
+	return new uint64_t(saturate_cast<uint64_t>(std::stoull(input)));
 }
 
 std::string hrtds::data::StaticConverter<uint64_t>::ToString(const void* data) 
@@ -1,5 +1,26 @@
 #pragma once
 #include ".\hrtds_data.h"
 
+// Strings too long for the small string buffer hold a heap block as well
+template<>
+struct hrtds::data::MemorySize<std::string> {
+	static size_t Of(const void* data) {
+		const std::string* string = static_cast<const std::string*>(data);
+		const char* characters = string->data();
+		bool small = characters >= reinterpret_cast<const char*>(string) && characters < reinterpret_cast<const char*>(string + 1);
+		return sizeof(std::string) + (small ? 0 : string->capacity() + 1);
+	}
+};
+
+// The characters alone, so that an owned string hashes like a borrowed one
+// (see hrtds::Value::isBorrowed())
+template<>
+struct hrtds::data::ContentHash<std::string> {
+	static uint64_t Of(const void* data) {
+		const std::string* string = static_cast<const std::string*>(data);
+		return HashBytes(string->data(), string->size());
+	}
+};
+
 HRTDS_DATA_STATIC_CONVERTER(std::string, "string");
 HRTDS_DATA_STATIC_CONVERTER(bool, "bool");
\ No newline at end of file
@@ -2,65 +2,212 @@
 
 #include <algorithm>
 #include <stdexcept>
+#include <utility>
 
+#include ".\hrtds_composer.h"
 #include ".\hrtds_config.h"
+#include ".\hrtds_schema.h"
+#include ".\hrtds_trace.h"
 #include ".\hrtds_utils.h"
-#include ".\data\hrtds_misc.h"
-#include ".\data\hrtds_decimal.h"
-#include ".\data\hrtds_integral.h"
 
+namespace {
+	// The control block std::make_shared puts in front of the object
+	constexpr size_t SHARED_BLOCK_SIZE = sizeof(void*) + 2 * sizeof(int);
 
-void hrtds::tokenizer::Token::SetTokenType(TokenType type)
+	// The heap block of a string too long for its small string buffer
+	size_t StringHeapBytes(const std::string& string)
+	{
+		return hrtds::data::MemorySize<std::string>::Of(&string) - sizeof(std::string);
+	}
+
+	// The bucket array and one node (next pointer and cached hash) per
+	// element, keys and values only counted by their size
+	template<typename Map>
+	size_t MapBytes(const Map& map)
+	{
+		return map.bucket_count() * sizeof(void*) + map.size() * (sizeof(typename Map::value_type) + sizeof(void*) + sizeof(size_t));
+	}
+
+	template<typename T>
+	size_t VectorBytes(const std::vector<T>& vector)
+	{
+		return vector.capacity() * sizeof(T);
+	}
+
+	void MeasureStructureLayout(const hrtds::StructureLayout& layout, hrtds::MemoryFootprint& footprint)
+	{
+		const std::vector<hrtds::LayoutElement>& elements = layout.GetLayoutElements();
+		footprint.layouts += VectorBytes(elements);
+		for (const hrtds::LayoutElement& element : elements)
+		{
+			footprint.layouts += StringHeapBytes(element.name);
+		}
+	}
+
+	void MeasureTupleLayout(const hrtds::TupleLayout& layout, hrtds::MemoryFootprint& footprint)
+	{
+		footprint.layouts += SHARED_BLOCK_SIZE + sizeof(hrtds::TupleLayout);
+		MeasureStructureLayout(layout.layout, footprint);
+
+		footprint.maps += MapBytes(layout.fieldMap);
+		for (const auto& [name, index] : layout.fieldMap)
+		{
+			footprint.maps += StringHeapBytes(name);
+		}
+	}
+}
+
+hrtds::tokenizer::Tape::Tape(std::string_view content, const StringBank& stringBank)
+	: content(content)
+	, stringBank(&stringBank)
+{}
+
+hrtds::tokenizer::Tape::Tape(std::string_view content, const StringBank& stringBank, std::vector<TapeEntry>&& storage)
+	: entries(std::move(storage))
+	, content(content)
+	, stringBank(&stringBank)
 {
-	this->tokenType = type;
+	this->entries.clear();
 }
 
-hrtds::tokenizer::TokenType hrtds::tokenizer::Token::GetTokenType() const
+std::vector<hrtds::tokenizer::TapeEntry> hrtds::tokenizer::Tape::Release()
 {
-	return this->tokenType;
+	return std::move(this->entries);
 }
 
-void hrtds::tokenizer::Token::SetValueType(ValueType type)
+const hrtds::tokenizer::TapeEntry& hrtds::tokenizer::Tape::operator[](size_t index) const
 {
-	this->valueType = type;
+	return this->entries[index];
 }
 
-hrtds::tokenizer::ValueType hrtds::tokenizer::Token::GetValueType() const
+size_t hrtds::tokenizer::Tape::size() const
 {
-	return this->valueType;
+	return this->entries.size();
 }
 
-void hrtds::tokenizer::Token::AddChild(Token token)
+std::string_view hrtds::tokenizer::Tape::GetText(size_t index) const
 {
-	this->children.push_back(token);
+	const TapeEntry& entry = this->entries[index];
+	if (entry.quoted) {
+		return this->stringBank->strings[entry.begin];
+	}
+
+	return this->content.substr(entry.begin, entry.length);
 }
 
-std::vector<hrtds::tokenizer::Token>& hrtds::tokenizer::Token::GetChildren()
+bool hrtds::tokenizer::Tape::isBorrowed(size_t index) const
 {
-	return this->children;
+	return this->entries[index].quoted && this->stringBank->borrowed;
 }
 
-void hrtds::tokenizer::Token::SetData(const std::string& data)
+void hrtds::tokenizer::StructureIndex::Build(std::string_view content)
 {
-	this->data = data;
+	this->marks.clear();
+
+	// The open containers, with the last mark of each one's chain
+	struct Open {
+		size_t mark;
+		size_t last;
+	};
+
+	std::vector<Open> open;
+	for (size_t i = 0; i < content.size(); i++)
+	{
+		char current = content[i];
+		switch (current)
+		{
+			case config::Glyph::BEGIN_SCOPE:
+			case config::Glyph::BEGIN_ARRAY:
+			case config::Glyph::BEGIN_TUPLE: {
+				open.push_back({ this->marks.size(), this->marks.size() });
+				this->marks.push_back({ i, 0 });
+				break;
+			}
+
+			case config::Glyph::LIST_SEPARATOR: {
+				// Fields are separated by terminators, not by these
+				if (open.empty()) {
+					break;
+				}
+
+				this->marks[open.back().last].next = this->marks.size();
+				open.back().last = this->marks.size();
+				this->marks.push_back({ i, 0 });
+				break;
+			}
+
+			case config::Glyph::END_SCOPE:
+			case config::Glyph::END_ARRAY:
+			case config::Glyph::END_TUPLE: {
+				char opening = open.empty() ? '\0' : content[this->marks[open.back().mark].position];
+				bool matching = (opening == config::Glyph::BEGIN_SCOPE && current == config::Glyph::END_SCOPE)
+					|| (opening == config::Glyph::BEGIN_ARRAY && current == config::Glyph::END_ARRAY)
+					|| (opening == config::Glyph::BEGIN_TUPLE && current == config::Glyph::END_TUPLE);
+
+				if (!matching) {
+					throw std::runtime_error("Every closing glyph needs a matching opening one. (Found a '" + std::string(1, current) + "' which closes nothing)");
+				}
+
+				this->marks[open.back().last].next = this->marks.size();
+				this->marks.push_back({ i, 0 });
+				open.pop_back();
+				break;
+			}
+
+			default: break;
+		}
+	}
+
+	if (!open.empty()) {
+		throw std::runtime_error("Every opening glyph needs a matching closing one. (Found a '" + std::string(1, content[this->marks[open.back().mark].position]) + "' which is never closed)");
+	}
 }
 
-std::string hrtds::tokenizer::Token::GetData() const
+const hrtds::tokenizer::StructureIndex::Mark& hrtds::tokenizer::StructureIndex::operator[](size_t index) const
 {
-	return this->data;
+	return this->marks[index];
+}
+
+size_t hrtds::tokenizer::StructureIndex::size() const
+{
+	return this->marks.size();
+}
+
+size_t hrtds::tokenizer::StructureIndex::Seek(size_t from, size_t position) const
+{
+	while (from < this->marks.size() && this->marks[from].position < position)
+	{
+		from++;
+	}
+
+	return from;
+}
+
+hrtds::tokenizer::Tape hrtds::tokenizer::Tokenizer::Tokenize(const std::string& content, const StringBank& stringBank)
+{
+	StructureIndex index;
+	return Tokenizer::Tokenize(content, stringBank, std::vector<TapeEntry>(), index);
 }
 
-std::vector<hrtds::tokenizer::Token> hrtds::tokenizer::Tokenizer::Tokenize(const std::string& content, const std::vector<std::string>& stringBank)
+hrtds::tokenizer::Tape hrtds::tokenizer::Tokenizer::Tokenize(const std::string& content, const StringBank& stringBank, std::vector<TapeEntry>&& storage)
 {
-	// Tokenize file (first pass)
-	std::vector<Token> tokens;
+	StructureIndex index;
+	return Tokenizer::Tokenize(content, stringBank, std::move(storage), index);
+}
+
+hrtds::tokenizer::Tape hrtds::tokenizer::Tokenizer::Tokenize(const std::string& content, const StringBank& stringBank, std::vector<TapeEntry>&& storage, StructureIndex& index)
+{
+	Tape tape = Tape(content, stringBank, std::move(storage));
+	index.Build(content);
+
+	// Only moves forward, as the fields do
+	size_t mark = 0;
 	for (size_t i = 0; i < content.size(); i++)
 	{
-		// The layout will be [Identifier][Defining][Value] for the 
-		// first pass, it's in the second we tokennize the [Value] tokens
+		// Every field is [Identifier][Defining][Value], followed by 
+		// whatever the value contains
 		
 		// [Identifier] (&...&)
-		Token identifierToken = Token(TokenType::IDENTIFIER);
 		size_t identifierBegin = content.find(config::Glyph::IDENTIFIER, i);
 		size_t identifierEnd = content.find(config::Glyph::IDENTIFIER, identifierBegin + 1);
 
@@ -69,11 +216,10 @@ std::vector<hrtds::tokenizer::Token> hrtds::tokenizer::Tokenizer::Tokenize(const
 		}
 
 		identifierBegin++;
-		std::string identifierString = content.substr(identifierBegin, (identifierEnd - identifierBegin));
-		identifierToken.SetData(identifierString);
+		size_t identifierEntry = tape.entries.size();
+		tape.entries.push_back({ TokenType::IDENTIFIER, ValueType::SCOPE, false, 0, identifierBegin, (identifierEnd - identifierBegin), identifierEntry + 1 });
 
 		// [Defining] (&...:)
-		Token definingToken = Token(TokenType::DEFINING);
 		size_t definingBegin = identifierEnd;
 		size_t definingEnd = content.find(config::Glyph::ASSIGNMENT, definingBegin + 1);
 
@@ -82,11 +228,10 @@ std::vector<hrtds::tokenizer::Token> hrtds::tokenizer::Tokenizer::Tokenize(const
 			throw std::runtime_error("In order to declare the name of a field you need to wrap it in a '" + std::to_string(config::Glyph::IDENTIFIER) + "' and '" + std::to_string(config::Glyph::ASSIGNMENT) + "'");
 		}
 
-		std::string definingString = content.substr(definingBegin, (definingEnd - definingBegin));
-		definingToken.SetData(definingString);
+		size_t definingEntry = tape.entries.size();
+		tape.entries.push_back({ TokenType::DEFINING, ValueType::SCOPE, false, 0, definingBegin, (definingEnd - definingBegin), definingEntry + 1 });
 
 		// [Value] (:...;)
-		Token valueToken = Token(TokenType::VALUE);
 		size_t valueBegin = definingEnd;
 		size_t valueEnd = content.find(config::Glyph::TERMINATOR, valueBegin + 1);
 
@@ -95,77 +240,76 @@ std::vector<hrtds::tokenizer::Token> hrtds::tokenizer::Tokenizer::Tokenize(const
 			throw std::runtime_error("In order to declare the name of a field you need to wrap it in a '" + std::to_string(config::Glyph::IDENTIFIER) + "' and '" + std::to_string(config::Glyph::ASSIGNMENT) + "'");
 		}
 
-		std::string valueString = content.substr(valueBegin, (valueEnd - valueBegin));
-		valueToken.SetData(valueString);
-
-		// Add tokens
-		tokens.reserve(tokens.size() + 3);
-		tokens.push_back(identifierToken);
-		tokens.push_back(definingToken);
-		tokens.push_back(valueToken);
+		mark = index.Seek(mark, valueBegin);
+		Tokenizer::TokenizeValue(tape, index, valueBegin, (valueEnd - valueBegin), mark, true);
 
 		// Move cursor
 		i = valueEnd;
 	}
 
-	// Tokenize file (second pass)
-	for (size_t i = 0; i < tokens.size(); i++)
-	{
-		Token& token = tokens.at(i);
-		if (token.GetTokenType() != TokenType::VALUE) {
-			continue;
-		}
+	return tape;
+}
 
-		switch (token.GetData()[0])
-		{
-			case config::Glyph::BEGIN_SCOPE: { 
-				Tokenizer::TokenizeScope(token, stringBank); break;
-			}
-			case config::Glyph::BEGIN_ARRAY: {
-				Tokenizer::TokenizeArray(token, stringBank); break;
-			}
-			case config::Glyph::BEGIN_TUPLE: {
-				Tokenizer::TokenizeTuple(token, stringBank); break;
-			}
+void hrtds::tokenizer::Tokenizer::TokenizeValue(Tape& tape, const StructureIndex& index, size_t begin, size_t length, size_t mark, bool allowScope)
+{
+	size_t entry = tape.entries.size();
+	tape.entries.push_back({ TokenType::VALUE, ValueType::DATA, false, 0, begin, length });
 
-			default: {
-				Tokenizer::TokenizeData(token, stringBank); continue;
+	char first = length > 0 ? tape.content[begin] : '\0';
+	switch (first)
+	{
+		case config::Glyph::BEGIN_SCOPE: {
+			if (!allowScope) {
+				throw std::runtime_error("You cannot define a scope inside an array. (Scope-begin-marker found as array element)");
 			}
-		}		
+
+			tape.entries[entry].valueType = ValueType::SCOPE;
+			Tokenizer::TokenizeScope(tape, index, entry, mark); break;
+		}
+		case config::Glyph::BEGIN_ARRAY: {
+			tape.entries[entry].valueType = ValueType::ARRAY;
+			Tokenizer::TokenizeList(tape, index, entry, mark); break;
+		}
+		case config::Glyph::BEGIN_TUPLE: {
+			tape.entries[entry].valueType = ValueType::TUPLE;
+			Tokenizer::TokenizeList(tape, index, entry, mark); break;
+		}
+		default: {
+			Tokenizer::TokenizeData(tape, entry); break;
+		}
 	}
 
-	return tokens;
+	tape.entries[entry].close = tape.entries.size();
 }
 
-void hrtds::tokenizer::Tokenizer::TokenizeScope(Token& parent, const std::vector<std::string>& stringBank)
+void hrtds::tokenizer::Tokenizer::TokenizeScope(Tape& tape, const StructureIndex& index, size_t parent, size_t mark)
 {
-	std::string content = parent.GetData(); // { <content> }
-	content.erase(content.begin()); // { <content> }
-	content.pop_back(); // <content> } 
-	// resulting in <content>
-
-	// Configure the parent token
-	parent.SetTokenType(TokenType::VALUE);
-	parent.SetValueType(ValueType::SCOPE);
-
-	// Find every list separator on the same level
-	std::vector<size_t> listSeparators = utils::RetrieveSameLevelSeparators(content);
-	listSeparators.push_back(content.size()); // Includes the last list element
+	size_t scopeBegin = tape.entries[parent].begin;
+	size_t scopeLength = tape.entries[parent].length;
+	if (scopeLength < 2) {
+		throw std::runtime_error("A scope needs both an opening and a closing glyph.");
+	}
 
-	// Tokenize (first pass)
-	std::vector<Token>& children = parent.GetChildren();
-	size_t cursor = 0;
-	for (size_t i = 0; i < listSeparators.size(); i++)
+	// { <content> }, every element ends at the next mark of the chain
+	size_t cursor = scopeBegin + 1;
+	size_t scopeEnd = scopeBegin + scopeLength - 1;
+	size_t boundary = mark;
+	while (true)
 	{
 		// Locate the current list element
-		size_t listSeparator = listSeparators[i];
-		std::string listElement = content.substr(cursor, (listSeparator - cursor));
+		boundary = index[boundary].next;
+		size_t listSeparator = index[boundary].position;
+		if (listSeparator > scopeEnd) {
+			throw std::runtime_error("A scope needs both an opening and a closing glyph.");
+		}
+
+		std::string_view listElement = tape.content.substr(cursor, (listSeparator - cursor));
+		size_t elementBegin = cursor;
 		
 		// For a struct scope we expect the token layout to 
 		// be [Identifier][Declaring].
 
 		// [Identifier] (&...&)
-		Token identifierToken = Token(TokenType::IDENTIFIER);
 		size_t identifierBegin = listElement.find(config::Glyph::IDENTIFIER);
 		size_t identifierEnd = listElement.find(config::Glyph::IDENTIFIER, identifierBegin + 1);
 
@@ -174,156 +318,83 @@ void hrtds::tokenizer::Tokenizer::TokenizeScope(Token& parent, const std::vector
 		}
 
 		identifierBegin++;
-		std::string identifierString = listElement.substr(identifierBegin, (identifierEnd - identifierBegin));
-		identifierToken.SetData(identifierString);
+		size_t identifierEntry = tape.entries.size();
+		tape.entries.push_back({ TokenType::IDENTIFIER, ValueType::SCOPE, false, 0, elementBegin + identifierBegin, (identifierEnd - identifierBegin), identifierEntry + 1 });
 		
 		// [Declaring] (&...,)
-		Token declaringToken = Token(TokenType::DECLARING);
-		size_t declaringBegin = identifierEnd;
-		size_t declaringEnd = listElement.size();
-		if (declaringBegin == listElement.npos || declaringEnd == listElement.npos) {
-			throw std::runtime_error("In order to declare a declaring field name inside a struct scope, you need to wrap it in a '" + std::to_string(config::Glyph::IDENTIFIER) + "' and '" + std::to_string(config::Glyph::LIST_SEPARATOR) + "'");
-		}
+		size_t declaringBegin = identifierEnd + 1;
+		size_t declaringEntry = tape.entries.size();
+		tape.entries.push_back({ TokenType::DECLARING, ValueType::SCOPE, false, 0, elementBegin + declaringBegin, (listElement.size() - declaringBegin), declaringEntry + 1 });
 
-		declaringBegin++;
-		std::string declaringString = listElement.substr(declaringBegin, (declaringEnd - declaringBegin));
-		declaringToken.SetData(declaringString);
+		tape.entries[parent].children += 2;
 
-		// Add tokens
-		children.reserve(children.size() + 2);
-		children.push_back(identifierToken);
-		children.push_back(declaringToken);
+		// Up to the closing glyph
+		if (tape.content[listSeparator] != config::Glyph::LIST_SEPARATOR) break;
 
 		// Next element
 		cursor = listSeparator + 1;
 	}
-}
-
-void hrtds::tokenizer::Tokenizer::TokenizeArray(Token& parent, const std::vector<std::string>& stringBank)
-{
-	std::string content = parent.GetData(); // { <content> }
-	content.erase(content.begin()); // { <content> }
-	content.pop_back(); // <content> } 
-	// resulting in <content>
-
-	// Configure the parent token
-	parent.SetTokenType(TokenType::VALUE);
-	parent.SetValueType(ValueType::ARRAY);
 
-	// Find every list separator on the same level
-	std::vector<size_t> listSeparators = utils::RetrieveSameLevelSeparators(content);
-	listSeparators.push_back(content.size()); // Includes the last list element
-
-	// Tokenize
-	std::vector<Token>& children = parent.GetChildren();
-	size_t cursor = 0;
-	for (size_t i = 0; i < listSeparators.size(); i++)
-	{
-		// Locate the current list element
-		size_t listSeparator = listSeparators[i];
-		std::string listElement = content.substr(cursor, (listSeparator - cursor));
-		
-		// Create a simple value token from the listElement
-		Token listElementToken = Token(TokenType::VALUE);
-		listElementToken.SetData(listElement);
-
-		// Run a second pass over the token (it may be another array or tuple)
-		switch (listElementToken.GetData()[0])
-		{
-			case config::Glyph::BEGIN_SCOPE: {
-				throw std::runtime_error("You cannot define a scope inside an array. (Scope-begin-marker found as array element)");
-			}
-			case config::Glyph::BEGIN_ARRAY: {
-				Tokenizer::TokenizeArray(listElementToken, stringBank); break;
-			}
-			case config::Glyph::BEGIN_TUPLE: {
-				Tokenizer::TokenizeTuple(listElementToken, stringBank); break;
-			}
-			default: {
-				Tokenizer::TokenizeData(listElementToken, stringBank); break;
-			}
-		}
-
-		// Add token to children
-		children.push_back(listElementToken);
-		
-		// Next element
-		cursor = listSeparator + 1;
+	if (index[boundary].position != scopeEnd) {
+		throw std::runtime_error("A scope has to end with its closing glyph. (Found content after the closing glyph)");
 	}
 }
 
-void hrtds::tokenizer::Tokenizer::TokenizeTuple(Token& parent, const std::vector<std::string>& stringBank)
+void hrtds::tokenizer::Tokenizer::TokenizeList(Tape& tape, const StructureIndex& index, size_t parent, size_t mark)
 {
-	std::string content = parent.GetData(); // { <content> }
-	content.erase(content.begin()); // { <content> }
-	content.pop_back(); // <content> } 
-	// resulting in <content>
-
-	// Configure the parent token
-	parent.SetTokenType(TokenType::VALUE);
-	parent.SetValueType(ValueType::TUPLE);
-
-	// Find every list separator on the same level
-	std::vector<size_t> listSeparators = utils::RetrieveSameLevelSeparators(content);
-	listSeparators.push_back(content.size()); // Includes the last list element
+	size_t listBegin = tape.entries[parent].begin;
+	size_t listLength = tape.entries[parent].length;
+	if (listLength < 2) {
+		throw std::runtime_error("A list needs both an opening and a closing glyph.");
+	}
 
-	// Tokenize
-	std::vector<Token>& children = parent.GetChildren();
-	size_t cursor = 0;
-	for (size_t i = 0; i < listSeparators.size(); i++)
+	// [ <content> ] or ( <content> ), every element ends at the next mark
+	// of the chain and its own marks start right after the previous one
+	size_t cursor = listBegin + 1;
+	size_t listEnd = listBegin + listLength - 1;
+	size_t boundary = mark;
+	while (true)
 	{
-		size_t listSeparator = listSeparators[i];
-		std::string listElement = content.substr(cursor, (listSeparator - cursor));
-		// Create a simple value token from the listElement
-		Token listElementToken = Token(TokenType::VALUE);
-		listElementToken.SetData(listElement);
-
-		// Run a second pass over the token (it may be another array or tuple)
-		switch (listElementToken.GetData()[0])
-		{
-			case config::Glyph::BEGIN_SCOPE: {
-				throw std::runtime_error("You cannot define a scope inside an array. (Scope-begin-marker found as array element)");
-			}
-			case config::Glyph::BEGIN_ARRAY: {
-				Tokenizer::TokenizeArray(listElementToken, stringBank); break;
-			}
-			case config::Glyph::BEGIN_TUPLE: {
-				Tokenizer::TokenizeTuple(listElementToken, stringBank); break;
-			}
-			default: {
-				Tokenizer::TokenizeData(listElementToken, stringBank); break;
-			}
+		// Every element may be another array or tuple
+		size_t previous = boundary;
+		boundary = index[boundary].next;
+		size_t listSeparator = index[boundary].position;
+		if (listSeparator > listEnd) {
+			throw std::runtime_error("A list needs both an opening and a closing glyph.");
 		}
 
-		// Add token to children
-		children.push_back(listElementToken);
-		
+		Tokenizer::TokenizeValue(tape, index, cursor, (listSeparator - cursor), previous + 1, false);
+		tape.entries[parent].children++;
+
+		// Up to the closing glyph
+		if (tape.content[listSeparator] != config::Glyph::LIST_SEPARATOR) break;
+
 		// Next element
 		cursor = listSeparator + 1;
 	}
+
+	if (index[boundary].position != listEnd) {
+		throw std::runtime_error("A list has to end with its closing glyph. (Found content after the closing glyph)");
+	}
 }
 
-void hrtds::tokenizer::Tokenizer::TokenizeData(Token& dataToken, const std::vector<std::string>& stringBank)
+void hrtds::tokenizer::Tokenizer::TokenizeData(Tape& tape, size_t entry)
 {
-	// Configure token
-	dataToken.SetTokenType(TokenType::VALUE);
-	dataToken.SetValueType(ValueType::DATA);
-
-	// Repopulate if string
-	std::string data = dataToken.GetData();
-	if (data[0] == config::Glyph::QUOTE) {
-		std::string indexString = data; // "<index>"
-		indexString.erase(indexString.begin());	// Removes this ---> "<index>"
-		indexString.pop_back(); // Removes this <index>" <---
-		// resuling in <index>
-
-		// Claim string
-		int index = std::stoi(indexString);
-		std::string claimedString = stringBank[index];
+	// Strings are "<index>" into the string bank
+	TapeEntry& dataEntry = tape.entries[entry];
+	if (dataEntry.length < 2 || tape.content[dataEntry.begin] != config::Glyph::QUOTE) {
+		return;
+	}
 
-		// Repopulate
-		dataToken.SetData(claimedString);
+	std::string indexString = std::string(tape.content.substr(dataEntry.begin + 1, dataEntry.length - 2));
+	size_t index = static_cast<size_t>(std::stoi(indexString));
+	if (index >= tape.stringBank->strings.size()) {
+		throw std::runtime_error("Unknown string index: '" + indexString + "'.");
 	}
+
+	dataEntry.quoted = true;
+	dataEntry.begin = index;
+	dataEntry.length = 0;
 }
 
 hrtds::Identifier::Identifier(Identifier&& other) noexcept
@@ -380,12 +451,13 @@ hrtds::IdentifierType hrtds::Identifier::GetIdentifierType() const
 
 void hrtds::Identifier::SetIdentifierName(const std::string& name)
 {
-	this->name = name;
+	this->name = Identifier::Name(name);
 }
 
-std::string hrtds::Identifier::GetIdentifierName() const
+const std::string& hrtds::Identifier::GetIdentifierName() const
 {
-	return this->name;
+	static const std::string empty;
+	return this->name != nullptr ? *this->name : empty;
 }
 
 void hrtds::Identifier::SetArray(bool array)
@@ -408,6 +480,29 @@ bool hrtds::Identifier::isValid() const
 	return this->valid;
 }
 
+bool hrtds::Identifier::operator==(const Identifier& other) const
+{
+	bool sameName = this->name == other.name
+		|| (this->name != nullptr && other.name != nullptr && *this->name == *other.name);
+
+	return this->identifierType == other.identifierType
+		&& sameName
+		&& this->array == other.array
+		&& this->valid == other.valid;
+}
+
+std::shared_ptr<const std::string> hrtds::Identifier::Name(const std::string& name)
+{
+	// The registry is never emptied, so its names are pointed at without
+	// being owned (or locked)
+	auto converter = data::DynamicConverter::FromString.find(name);
+	if (converter != data::DynamicConverter::FromString.end()) {
+		return std::shared_ptr<const std::string>(std::shared_ptr<const std::string>(), &converter->first);
+	}
+
+	return std::make_shared<const std::string>(name);
+}
+
 hrtds::Identifier hrtds::Identifier::Determine(std::string identifierString, const HRTDS& hrtds)
 {
 	Identifier identifier;
@@ -420,10 +515,10 @@ hrtds::Identifier hrtds::Identifier::Determine(std::string identifierString, con
 		identifier.SetArray(true);
 	}
 
-	identifier.SetIdentifierName(identifierString);
-
 	// Determine if we are built-in or structure
-	if (data::DynamicConverter::FromString.count(identifierString)) {
+	auto converter = data::DynamicConverter::FromString.find(identifierString);
+	if (converter != data::DynamicConverter::FromString.end()) {
+		identifier.name = std::shared_ptr<const std::string>(std::shared_ptr<const std::string>(), &converter->first);
 		identifier.SetIdentifierType(IdentifierType::BUILTIN);
 		identifier.SetValid(true);
 		return identifier;
@@ -432,6 +527,7 @@ hrtds::Identifier hrtds::Identifier::Determine(std::string identifierString, con
 	const std::unordered_map<std::string, StructureLayout>& declaredStructures = hrtds.GetDeclaredStructures();
 	auto it = declaredStructures.find(identifierString);
 	if (it != declaredStructures.end()) {
+		identifier.name = hrtds.InternIdentifierName(identifierString);
 		identifier.SetIdentifierType(IdentifierType::TUPLE);
 		identifier.SetValid(true);
 		return identifier;
@@ -496,55 +592,97 @@ const std::vector<hrtds::LayoutElement>& hrtds::StructureLayout::GetLayoutElemen
 	return this->layout;
 }
 
-hrtds::StructureLayout hrtds::StructureLayout::Parse(tokenizer::Token& valueToken, const HRTDS& hrtds)
+hrtds::StructureLayout hrtds::StructureLayout::Parse(const tokenizer::Tape& tape, size_t valueEntry, const HRTDS& hrtds)
 {
 	StructureLayout layout;
 
-	std::vector<tokenizer::Token>& children = valueToken.GetChildren();
-	for (size_t i = 0; i < children.size(); i++)
+	const tokenizer::TapeEntry& scope = tape[valueEntry];
+	for (size_t i = valueEntry + 1; i < scope.close; i = tape[i].close)
 	{
-		// When parsing a valueToken for a structure layout we expect the 
+		// When parsing a scope for a structure layout we expect the 
 		// children to be [IDENTIFIER][DECLARING] repeating. We also work 
 		// from the identifier.
 
-		tokenizer::Token& identifierToken = children[i];
-		if (identifierToken.GetTokenType() != tokenizer::TokenType::IDENTIFIER) {
+		const tokenizer::TapeEntry& identifierEntry = tape[i];
+		if (identifierEntry.tokenType != tokenizer::TokenType::IDENTIFIER) {
 			continue;
 		}
 
-		tokenizer::Token& declaringToken = children[i + 1];
-		if (declaringToken.GetTokenType() != tokenizer::TokenType::DECLARING) {
-			throw std::runtime_error("In a field of a structure declaration, an identifying token has to be preceeded by a declaring one. (Expected tokentype DECLARING, but found " + std::to_string(static_cast<int>(declaringToken.GetTokenType())) + ")");
+		const tokenizer::TapeEntry& declaringEntry = tape[i + 1];
+		if (declaringEntry.tokenType != tokenizer::TokenType::DECLARING) {
+			throw std::runtime_error("In a field of a structure declaration, an identifying token has to be preceeded by a declaring one. (Expected tokentype DECLARING, but found " + std::to_string(static_cast<int>(declaringEntry.tokenType)) + ")");
 		}
 
-		Identifier identifier = Identifier::Determine(identifierToken.GetData(), hrtds);
+		std::string identifierString = std::string(tape.GetText(i));
+		Identifier identifier = Identifier::Determine(identifierString, hrtds);
 		if (!identifier.isValid()) {
-			throw std::runtime_error("Unrecognized identifier: '" + identifierToken.GetData() + "'. If you meant to use a custom struct make sure the name matches and the it's declarations exists before the use of it.");
+			throw std::runtime_error("Unrecognized identifier: '" + identifierString + "'. If you meant to use a custom struct make sure the name matches and the it's declarations exists before the use of it.");
 		}
 
-		layout.AddLayoutElement({ identifier, declaringToken.GetData() });
+		layout.AddLayoutElement({ identifier, std::string(tape.GetText(i + 1)) });
 	}
 
 	return layout;
 }
 
+std::shared_ptr<const hrtds::TupleLayout> hrtds::TupleLayout::Create(StructureLayout layout)
+{
+	std::shared_ptr<TupleLayout> tupleLayout = std::make_shared<TupleLayout>();
+	for (size_t i = 0; i < layout.GetLayoutElements().size(); i++)
+	{
+		tupleLayout->fieldMap[layout[i]->name] = static_cast<int>(i);
+	}
+
+	tupleLayout->layout = std::move(layout);
+	return tupleLayout;
+}
+
+size_t hrtds::MemoryFootprint::Total() const
+{
+	return this->nodes + this->slack + this->scalars + this->strings + this->layouts + this->maps;
+}
+
+hrtds::MemoryFootprint& hrtds::MemoryFootprint::operator+=(const MemoryFootprint& other)
+{
+	this->nodes += other.nodes;
+	this->slack += other.slack;
+	this->scalars += other.scalars;
+	this->strings += other.strings;
+	this->layouts += other.layouts;
+	this->maps += other.maps;
+	return *this;
+}
+
 hrtds::Value::Value(Value&& other) noexcept
 	: identifier(std::move(other.identifier))
-	, data(std::move(other.data))
+	, data(std::exchange(other.data, nullptr))
+	, borrowed(other.borrowed)
+	, hasBorrowed(std::exchange(other.hasBorrowed, false))
+	, skipped(std::exchange(other.skipped, false))
 	, children(std::move(other.children))
-	, layout(std::move(other.layout))
-	, fieldMap(std::move(other.fieldMap))
+	, layoutInfo(std::move(other.layoutInfo))
+	, hash(other.hash.exchange(HASH_NONE, std::memory_order_relaxed))
 {}
 
 hrtds::Value::~Value()
+{
+	this->ReleaseData();
+}
+
+void hrtds::Value::ReleaseData()
 {
 	if (this->identifier.GetIdentifierType() != IdentifierType::TUPLE &&
 		!this->identifier.isArray()	&&
-		!this->identifier.GetIdentifierName().empty()
+		!this->identifier.GetIdentifierName().empty() &&
+		this->data != nullptr
 	) {
-		std::string identifierName = this->identifier.GetIdentifierName();
-		data::DynamicConverter::Destroy[identifierName](this->data);
+		auto destroy = data::DynamicConverter::Destroy.find(this->identifier.GetIdentifierName());
+		if (destroy != data::DynamicConverter::Destroy.end()) {
+			destroy->second(this->data);
+		}
 	}
+
+	this->data = nullptr;
 }
 
 hrtds::Value& hrtds::Value::operator=(Value&& other) noexcept
@@ -554,27 +692,50 @@ hrtds::Value& hrtds::Value::operator=(Value&& other) noexcept
 	}
 
 	this->identifier = std::move(other.identifier);
-	this->data = std::move(other.data);
+	this->data = std::exchange(other.data, nullptr);
+	this->borrowed = other.borrowed;
+	this->hasBorrowed = std::exchange(other.hasBorrowed, false);
+	this->skipped = std::exchange(other.skipped, false);
 	this->children = std::move(other.children);
-	this->layout = std::move(other.layout);
-	this->fieldMap = std::move(other.fieldMap);
+	this->layoutInfo = std::move(other.layoutInfo);
+	this->hash.store(other.hash.exchange(HASH_NONE, std::memory_order_relaxed), std::memory_order_relaxed);
 
 	return *this;
 }
 
 hrtds::Value& hrtds::Value::operator[](size_t index)
 {
-	return this->children[index];
+	return this->GetChildren()[index];
 }
 
 hrtds::Value& hrtds::Value::operator[](const std::string& name)
 {
-	size_t childIndex = this->fieldMap.at(name);
-	return this->children[childIndex];
+	if (this->layoutInfo == nullptr) {
+		throw std::out_of_range("Only tuples can be accessed by field name. (The value has no layout)");
+	}
+
+	size_t childIndex = this->layoutInfo->fieldMap.at(name);
+	return this->GetChildren()[childIndex];
+}
+
+const hrtds::Value& hrtds::Value::operator[](size_t index) const
+{
+	return this->GetChildren()[index];
+}
+
+const hrtds::Value& hrtds::Value::operator[](const std::string& name) const
+{
+	if (this->layoutInfo == nullptr) {
+		throw std::out_of_range("Only tuples can be accessed by field name. (The value has no layout)");
+	}
+
+	size_t childIndex = this->layoutInfo->fieldMap.at(name);
+	return this->GetChildren()[childIndex];
 }
 
 void hrtds::Value::SetIdentifier(Identifier identifier)
 {
+	this->ForgetHash();
 	this->identifier = identifier;
 }
 
@@ -585,33 +746,56 @@ const hrtds::Identifier& hrtds::Value::GetIdentifier() const
 
 std::vector<hrtds::Value>& hrtds::Value::GetChildren()
 {
-	return this->children;
+	std::vector<Value>& children = this->MutableChildren();
+	this->OpenHash();
+	return children;
+}
+
+std::vector<hrtds::Value>& hrtds::Value::MutableChildren()
+{
+	this->Detach();
+	return *this->children;
+}
+
+void hrtds::Value::SetChildren(std::vector<Value> children)
+{
+	this->ForgetHash();
+	this->ReleaseData();
+	this->hasBorrowed = false;
+	this->skipped = false;
+	this->children = std::make_shared<std::vector<Value>>(std::move(children));
 }
 
 const std::vector<hrtds::Value>& hrtds::Value::GetChildren() const
 {
-	return this->children;
+	static const std::vector<Value> empty;
+	return this->children != nullptr ? *this->children : empty;
 }
 
-size_t hrtds::Value::size()
+size_t hrtds::Value::size() const
 {
-	return this->children.size();
+	return this->children != nullptr ? this->children->size() : 0;
 }
 
 void hrtds::Value::SetLayout(StructureLayout layout)
 {
-	this->layout = layout;
+	this->layoutInfo = TupleLayout::Create(std::move(layout));
+}
 
-	this->fieldMap.clear();
-	for (size_t i = 0; i < layout.GetLayoutElements().size(); i++)
-	{
-		fieldMap[layout[i]->name] = static_cast<int>(i);
-	}
+void hrtds::Value::SetLayout(std::shared_ptr<const TupleLayout> layout)
+{
+	this->layoutInfo = std::move(layout);
 }
 
 const hrtds::StructureLayout& hrtds::Value::GetLayout() const
 {
-	return this->layout;
+	static const StructureLayout empty;
+	return this->layoutInfo != nullptr ? this->layoutInfo->layout : empty;
+}
+
+const std::shared_ptr<const hrtds::TupleLayout>& hrtds::Value::GetTupleLayout() const
+{
+	return this->layoutInfo;
 }
 
 const void* hrtds::Value::Get() const
@@ -621,211 +805,887 @@ const void* hrtds::Value::Get() const
 
 void hrtds::Value::Set(void* data)
 {
-	this->children.clear();
+	this->ForgetHash();
+	this->hasBorrowed = false;
+	this->skipped = false;
+	this->children.reset();
 	this->data = data;
 }
 
-hrtds::Value hrtds::Value::Parse(Identifier& identifier, tokenizer::Token& valueToken, const HRTDS& hrtds)
+void hrtds::Value::SetBorrowed(std::string_view string)
 {
-	Value value = Value();
-	value.SetIdentifier(identifier);
+	this->ForgetHash();
+	this->children.reset();
+	this->data = nullptr;
+	this->borrowed = string;
+	this->hasBorrowed = true;
+	this->skipped = false;
+}
 
-	if (identifier.isArray()) {
-		std::vector<tokenizer::Token>& tokenChildren = valueToken.GetChildren();
-		size_t childAmount = tokenChildren.size();
+bool hrtds::Value::isBorrowed() const
+{
+	return this->hasBorrowed;
+}
 
-		std::vector<Value>& valueChildren = value.GetChildren();
-		valueChildren.clear();
-		valueChildren.reserve(childAmount);
+void hrtds::Value::SetSkipped(bool skipped)
+{
+	this->ForgetHash();
+	this->skipped = skipped;
+}
 
-		for (size_t i = 0; i < childAmount; i++)
-		{
-			Identifier childIdentifier = Identifier::Determine(identifier.GetIdentifierName(), hrtds);
-			valueChildren.emplace_back(std::move(hrtds::Value::Parse(childIdentifier, tokenChildren[i], hrtds)));
-		}
+bool hrtds::Value::isSkipped() const
+{
+	return this->skipped;
+}
 
-		return value;
+hrtds::Value& hrtds::Value::Append(Value&& value)
+{
+	if (!this->identifier.isArray()) {
+		throw std::invalid_argument("Only arrays can be appended to, '" + this->identifier.GetIdentifierName() + "' is not one.");
 	}
 
-	switch (identifier.GetIdentifierType())
-	{
-		case IdentifierType::TUPLE: {
-			std::vector<tokenizer::Token>& tokenChildren = valueToken.GetChildren();
-			size_t childAmount = tokenChildren.size();
-
-			StructureLayout childLayout = hrtds.GetDeclaredStructures().at(identifier.GetIdentifierName());
-			std::vector<LayoutElement>& childLayoutElements = childLayout.GetLayoutElements();
-			size_t layoutAmount = childLayoutElements.size();
-
-			if (childAmount != layoutAmount) {
-				throw std::runtime_error("You need to match the amount of elements in tuple to the layout.");
-			}
-			
-			std::vector<Value>& valueChildren = value.GetChildren();
-			valueChildren.clear();
-			valueChildren.reserve(childAmount);
+	Identifier element = this->identifier;
+	element.SetArray(false);
+	Value::CheckIdentifier(element, value);
+	value.CheckComplete();
 
-			for (size_t i = 0; i < childAmount; i++)
-			{
-				valueChildren.emplace_back(std::move(hrtds::Value::Parse(childLayoutElements[i].identifier, tokenChildren[i], hrtds)));
-			}
-			
-			value.SetLayout(childLayout);
-			break;
-		}
-		case IdentifierType::BUILTIN: {
-			void* data = data::DynamicConverter::FromString[identifier.GetIdentifierName()](
-				valueToken.GetData()
-			);
+	std::vector<Value>& children = this->GetChildren();
+	children.push_back(std::move(value));
+	this->skipped = false;
+	return children.back();
+}
 
-			value.Set(data);
-			break;
-		}
-		default: break;
+void hrtds::Value::Reserve(size_t count)
+{
+	if (!this->identifier.isArray()) {
+		throw std::invalid_argument("Only arrays can be reserved, '" + this->identifier.GetIdentifierName() + "' is not one.");
 	}
 
-	return value;
+	this->MutableChildren().reserve(count);
 }
 
-std::string hrtds::Value::Compose(const Value& value, int level)
+void hrtds::Value::Set(const FieldHandle& handle, Value&& value)
 {
-	std::string composed;
-	const Identifier& identifier = value.GetIdentifier();
-	bool isList = identifier.isArray() || identifier.GetIdentifierType() == IdentifierType::TUPLE;
-	if (!isList) {
-		composed = data::DynamicConverter::ToString[identifier.GetIdentifierName()](value.Get());
-		return composed;
+	handle.Check(*this);
+	Value& field = this->MutableChildren()[handle.GetIndex()];
+	Value::CheckIdentifier(handle.GetLayoutElement().identifier, value);
+	value.CheckComplete();
+
+	// Moving over a value does not destroy its data
+	field.ReleaseData();
+	field = std::move(value);
+}
+
+void hrtds::Value::CheckComplete() const
+{
+	if (this->identifier.isArray() || this->identifier.GetIdentifierType() != IdentifierType::TUPLE) {
+		return;
 	}
 
-	bool expandAsArray = identifier.isArray() && identifier.GetIdentifierType() == IdentifierType::TUPLE;
-	bool expandAsTuple = false;
-	const std::vector<Value>& children = value.GetChildren();
+	const std::vector<LayoutElement>& elements = this->GetLayout().GetLayoutElements();
+	const std::vector<Value>& children = this->GetChildren();
+	if (children.size() != elements.size()) {
+		throw std::runtime_error("You need to match the amount of elements in tuple to the layout.");
+	}
 
-	for (const Value& child : children)
+	for (size_t i = 0; i < children.size(); i++)
 	{
-		const Identifier& childIdentifier = child.GetIdentifier();
-		expandAsTuple = childIdentifier.isArray() || childIdentifier.GetIdentifierType() == IdentifierType::TUPLE;
+		const Value& child = children[i];
+		bool tuple = !child.identifier.isArray() && child.identifier.GetIdentifierType() == IdentifierType::TUPLE;
+		bool set = !child.skipped && (child.identifier.isArray()
+			|| (tuple && child.layoutInfo != nullptr)
+			|| child.data != nullptr
+			|| child.hasBorrowed);
+
+		if (!set) {
+			throw std::invalid_argument("The field '" + elements[i].name + "' of a '" + this->identifier.GetIdentifierName() + "' was never set.");
+		}
 
-		if (expandAsTuple) {
-			break;
+		if (tuple) {
+			child.CheckComplete();
 		}
 	}
+}
 
-	bool expand = expandAsArray || expandAsTuple;
-	const char BEGIN_CHAR = identifier.isArray() ? 
-		config::Glyph::BEGIN_ARRAY : 
-		config::Glyph::BEGIN_TUPLE;
+void hrtds::Value::CheckIdentifier(const Identifier& expected, const Value& value)
+{
+	if (value.identifier == expected) {
+		return;
+	}
 
-	const char END_CHAR = identifier.isArray() ?
-		config::Glyph::END_ARRAY :
-		config::Glyph::END_TUPLE;
+	throw std::invalid_argument("Expected a value of type '" + expected.GetIdentifierName() + (expected.isArray() ? "[]" : "")
+		+ "', but got a '" + value.identifier.GetIdentifierName() + (value.identifier.isArray() ? "[]" : "") + "'.");
+}
 
-	composed += std::string()
-		+ BEGIN_CHAR
-		+ (expand ? std::string() 
-				+ config::Glyph::WHITESPACE_NEWLINE 
-		: "");
-	
-	for (size_t i = 0; i < children.size(); i++)
-	{
-		std::string separator = std::string()
-			+ config::Glyph::LIST_SEPARATOR
-			+ config::Glyph::WHITESPACE_SPACE
-			+ (expand ? std::string() + config::Glyph::WHITESPACE_NEWLINE : "");
+std::string_view hrtds::Value::GetString() const
+{
+	if (this->hasBorrowed) {
+		return this->borrowed;
+	}
+
+	if (this->identifier.isArray() || this->identifier.GetIdentifierName() != "string") {
+		throw std::invalid_argument("Only string values can be retrieved as a string.");
+	}
 
-		std::string indentation = std::string()
-			+ std::string(level + 1, config::Glyph::WHITESPACE_TAB);
+	return this->data != nullptr ? std::string_view(*reinterpret_cast<const std::string*>(this->data)) : std::string_view();
+}
 
-		bool first = i == 0;
-		composed += std::string()
-			+ (!first ? separator : "")
-			+ (expand ? indentation : "")
-			+ hrtds::Value::Compose(children[i], level + 1);
+void hrtds::Value::DetachStrings()
+{
+	if (this->hasBorrowed) {
+		this->data = new std::string(this->borrowed);
+		this->borrowed = {};
+		this->hasBorrowed = false;
+		return;
 	}
 
-	composed += std::string()
-		+ (expand ? std::string()
-				+ config::Glyph::WHITESPACE_NEWLINE
-				+ std::string(level, config::Glyph::WHITESPACE_TAB)
-		: "")
-		+ END_CHAR;
+	if (this->children == nullptr) {
+		return;
+	}
 
-	return composed;
+	for (Value& child : this->MutableChildren())
+	{
+		child.DetachStrings();
+	}
+}
+
+hrtds::Value hrtds::Value::Clone() const
+{
+	Value clone = Value();
+	clone.identifier = this->identifier;
+	clone.layoutInfo = this->layoutInfo;
+	clone.skipped = this->skipped;
+	clone.hash.store(this->hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+	bool isList = this->identifier.isArray() || this->identifier.GetIdentifierType() == IdentifierType::TUPLE;
+	if (!isList) {
+		if (this->hasBorrowed) {
+			clone.SetBorrowed(this->borrowed);
+		}
+		else if (this->data != nullptr && !this->identifier.GetIdentifierName().empty()) {
+			clone.data = data::DynamicConverter::Duplicate(this->identifier.GetIdentifierName(), this->data);
+		}
+
+		return clone;
+	}
+
+	clone.children = this->children;
+	return clone;
+}
+
+bool hrtds::Value::isShared() const
+{
+	return this->children != nullptr && this->children.use_count() > 1;
+}
+
+uint64_t hrtds::Value::Hash() const
+{
+	uint64_t hash = this->hash.load(std::memory_order_relaxed);
+	if (hash != HASH_NONE && hash != HASH_OPEN) {
+		return hash;
+	}
+
+	const std::string& identifierName = this->identifier.GetIdentifierName();
+	hash = data::HashBytes(identifierName.data(), identifierName.size());
+	hash = data::HashCombine(hash, this->identifier.isArray());
+
+	bool isList = this->identifier.isArray() || this->identifier.GetIdentifierType() == IdentifierType::TUPLE;
+	if (isList) {
+		const std::vector<Value>& children = this->GetChildren();
+		hash = data::HashCombine(hash, children.size());
+		for (const Value& child : children)
+		{
+			hash = data::HashCombine(hash, child.Hash());
+		}
+	}
+	else if (this->hasBorrowed) {
+		hash = data::HashCombine(hash, data::HashBytes(this->borrowed.data(), this->borrowed.size()));
+	}
+	else if (this->data != nullptr && !identifierName.empty()) {
+		hash = data::HashCombine(hash, data::DynamicConverter::HashOf(identifierName, this->data));
+	}
+
+	// HASH_NONE and HASH_OPEN are states rather than hashes
+	if (hash == HASH_NONE || hash == HASH_OPEN) {
+		hash += 2;
+	}
+
+	// Kept unless a mutable reference was handed out meanwhile
+	uint64_t none = HASH_NONE;
+	this->hash.compare_exchange_strong(none, hash, std::memory_order_relaxed);
+	return hash;
+}
+
+hrtds::MemoryFootprint hrtds::Value::MemoryUsage() const
+{
+	MemoryFootprint footprint;
+	footprint.nodes += sizeof(Value);
+
+	std::unordered_set<const void*> counted;
+	this->MeasureMemory(footprint, counted);
+
+	return footprint;
+}
+
+void hrtds::Value::ShrinkToFit()
+{
+	if (this->children == nullptr || this->children.use_count() != 1) {
+		return;
+	}
+
+	this->children->shrink_to_fit();
+	for (Value& child : *this->children)
+	{
+		child.ShrinkToFit();
+	}
+}
+
+void hrtds::Value::MeasureMemory(MemoryFootprint& footprint, std::unordered_set<const void*>& counted) const
+{
+	if (this->layoutInfo != nullptr && counted.insert(this->layoutInfo.get()).second) {
+		MeasureTupleLayout(*this->layoutInfo, footprint);
+	}
+
+	if (this->data != nullptr) {
+		const std::string& identifierName = this->identifier.GetIdentifierName();
+		auto sizeOf = data::DynamicConverter::SizeOf.find(identifierName);
+		size_t size = sizeOf != data::DynamicConverter::SizeOf.end() ? sizeOf->second(this->data) : 0;
+
+		if (identifierName == data::StaticConverter<std::string>::Alias) footprint.strings += size;
+		else footprint.scalars += size;
+	}
+
+	// Every Value is counted by the vector holding it
+	if (this->children == nullptr || !counted.insert(this->children.get()).second) {
+		return;
+	}
+
+	const std::vector<Value>& children = *this->children;
+	footprint.nodes += SHARED_BLOCK_SIZE + sizeof(std::vector<Value>) + children.size() * sizeof(Value);
+	footprint.slack += (children.capacity() - children.size()) * sizeof(Value);
+	for (const Value& child : children)
+	{
+		child.MeasureMemory(footprint, counted);
+	}
+}
+
+void hrtds::Value::Detach()
+{
+	// Whoever asks for our children may change them
+	this->ForgetHash();
+
+	if (this->children == nullptr) {
+		this->children = std::make_shared<std::vector<Value>>();
+		return;
+	}
+
+	// Only reliable while no other thread clones us meanwhile, which the
+	// single writer rule of hrtds::Value rules out
+	if (this->children.use_count() == 1) {
+		return;
+	}
+
+	// Copy this level only, the grandchildren stay shared
+	std::shared_ptr<std::vector<Value>> detached = std::make_shared<std::vector<Value>>();
+	detached->reserve(this->children->size());
+	for (const Value& child : *this->children)
+	{
+		detached->emplace_back(child.Clone());
+	}
+
+	this->children = std::move(detached);
+}
+
+hrtds::Value hrtds::Value::Parse(Identifier& identifier, const tokenizer::Tape& tape, size_t valueEntry, const HRTDS& hrtds)
+{
+	return Value::Parse(identifier, tape, valueEntry, hrtds, false);
+}
+
+hrtds::Value hrtds::Value::Parse(Identifier& identifier, const tokenizer::Tape& tape, size_t valueEntry, const HRTDS& hrtds, bool intern)
+{
+	Value value = Value();
+	value.SetIdentifier(identifier);
+
+	const tokenizer::TapeEntry& entry = tape[valueEntry];
+	if (identifier.isArray()) {
+		size_t childAmount = entry.children;
+
+		std::vector<Value>& valueChildren = value.MutableChildren();
+		valueChildren.clear();
+		valueChildren.reserve(childAmount);
+
+		// Every element is of our type, minus the array
+		Identifier childIdentifier = identifier;
+		childIdentifier.SetArray(false);
+		for (size_t i = valueEntry + 1; i < entry.close; i = tape[i].close)
+		{
+			valueChildren.emplace_back(std::move(hrtds::Value::Parse(childIdentifier, tape, i, hrtds, intern)));
+		}
+
+		return value;
+	}
+
+	switch (identifier.GetIdentifierType())
+	{
+		case IdentifierType::TUPLE: {
+			size_t childAmount = entry.children;
+
+			// Shared with every other tuple of this struct
+			std::shared_ptr<const TupleLayout> childLayout = hrtds.GetTupleLayout(identifier.GetIdentifierName());
+			if (childLayout == nullptr) {
+				childLayout = TupleLayout::Create(hrtds.GetDeclaredStructures().at(identifier.GetIdentifierName()));
+			}
+
+			const std::vector<LayoutElement>& childLayoutElements = childLayout->layout.GetLayoutElements();
+			size_t layoutAmount = childLayoutElements.size();
+
+			if (childAmount != layoutAmount) {
+				throw std::runtime_error("You need to match the amount of elements in tuple to the layout.");
+			}
+			
+			std::vector<Value>& valueChildren = value.MutableChildren();
+			valueChildren.clear();
+			valueChildren.reserve(childAmount);
+
+			const InternPool* pool = hrtds.GetInternPool().get();
+			bool internFields = pool != nullptr && pool->hasInternedFields();
+
+			size_t child = valueEntry + 1;
+			for (size_t i = 0; i < childAmount; i++)
+			{
+				Identifier childIdentifier = childLayoutElements[i].identifier;
+				bool internChild = internFields && pool->isInternedField(childLayoutElements[i].name);
+				valueChildren.emplace_back(std::move(hrtds::Value::Parse(childIdentifier, tape, child, hrtds, internChild)));
+				child = tape[child].close;
+			}
+			
+			value.SetLayout(std::move(childLayout));
+			break;
+		}
+		case IdentifierType::BUILTIN: {
+			if (intern && identifier.GetIdentifierName() == "string") {
+				value.SetBorrowed(hrtds.GetInternPool()->Intern(tape.GetText(valueEntry)));
+				break;
+			}
+
+			if (tape.isBorrowed(valueEntry) && identifier.GetIdentifierName() == "string") {
+				value.SetBorrowed(tape.GetText(valueEntry));
+				break;
+			}
+
+			void* data = data::DynamicConverter::FromText(identifier.GetIdentifierName(), tape.GetText(valueEntry));
+
+			value.Set(data);
+			break;
+		}
+		default: break;
+	}
+
+	return value;
+}
+
+std::string hrtds::Value::Compose(const Value& value, int level)
+{
+	return Composer(ComposeMode::PRETTY).Compose(value, level);
+}
+
+std::string hrtds::Value::Compose(const Value& value, int level, ComposeMode mode)
+{
+	return Composer(mode).Compose(value, level);
+}
+
+hrtds::FieldHandle::FieldHandle(const HRTDS& hrtds, const std::string& structure, const std::string& field)
+	: layout(hrtds.GetTupleLayout(structure))
+	, structure(structure)
+{
+	if (this->layout == nullptr) {
+		auto it = hrtds.GetDeclaredStructures().find(structure);
+		if (it == hrtds.GetDeclaredStructures().end()) {
+			throw std::invalid_argument("There is no struct named '" + structure + "'.");
+		}
+
+		this->layout = TupleLayout::Create(it->second);
+	}
+
+	auto it = this->layout->fieldMap.find(field);
+	if (it == this->layout->fieldMap.end()) {
+		throw std::invalid_argument("The struct '" + structure + "' has no field named '" + field + "'.");
+	}
+
+	this->index = static_cast<size_t>(it->second);
+}
+
+const std::string& hrtds::FieldHandle::GetStructureName() const
+{
+	return this->structure;
+}
+
+const hrtds::LayoutElement& hrtds::FieldHandle::GetLayoutElement() const
+{
+	return this->layout->layout.GetLayoutElements()[this->index];
+}
+
+size_t hrtds::FieldHandle::GetIndex() const
+{
+	return this->index;
+}
+
+bool hrtds::FieldHandle::isValid() const
+{
+	return this->layout != nullptr;
+}
+
+void hrtds::FieldHandle::CheckByName(const Value& tuple) const
+{
+	if (this->layout == nullptr) {
+		throw std::logic_error("The field handle has not been resolved.");
+	}
+
+	// Same struct, but not the layout we resolved against
+	const Identifier& identifier = tuple.GetIdentifier();
+	const std::vector<LayoutElement>& elements = tuple.GetLayout().GetLayoutElements();
+	bool matches = !identifier.isArray()
+		&& identifier.GetIdentifierType() == IdentifierType::TUPLE
+		&& identifier.GetIdentifierName() == this->structure
+		&& this->index < elements.size()
+		&& elements[this->index].name == this->GetLayoutElement().name
+		&& tuple.size() == elements.size();
+
+	if (!matches) {
+		throw std::invalid_argument("The value is not a tuple of the struct '" + this->structure + "'.");
+	}
 }
 
 hrtds::HRTDS::HRTDS(HRTDS&& other) noexcept
-	: declaredStructures(std::move(other.declaredStructures))
+	: structures(std::move(other.structures))
 	, fields(std::move(other.fields))
+	, internPool(std::move(other.internPool))
+	, identifierNames(std::move(other.identifierNames))
 {}
 
+hrtds::HRTDS& hrtds::HRTDS::operator=(HRTDS&& other) noexcept
+{
+	if (this == &other) {
+		return *this;
+	}
+
+	this->structures = std::move(other.structures);
+	this->fields = std::move(other.fields);
+	this->internPool = std::move(other.internPool);
+	this->identifierNames = std::move(other.identifierNames);
+
+	return *this;
+}
+
 void hrtds::HRTDS::DeclareStructure(const std::string& name, StructureLayout layout)
 {
-	this->declaredStructures[name] = layout;
-	this->structureOrder.push_back(name);
+	if (this->identifierNames == nullptr) {
+		this->identifierNames = std::make_shared<InternPool>();
+	}
+
+	Structures& structures = this->MutableStructures();
+	structures.declaredStructures[name] = layout;
+	structures.structureOrder.push_back(name);
+	structures.tupleLayouts[name] = TupleLayout::Create(std::move(layout));
+}
+
+void hrtds::HRTDS::DeclareStructure(const std::string& name, std::shared_ptr<const TupleLayout> layout)
+{
+	if (this->identifierNames == nullptr) {
+		this->identifierNames = std::make_shared<InternPool>();
+	}
+
+	Structures& structures = this->MutableStructures();
+	structures.declaredStructures[name] = layout->layout;
+	structures.structureOrder.push_back(name);
+	structures.tupleLayouts[name] = std::move(layout);
 }
 
 hrtds::StructureLayout* hrtds::HRTDS::RetrieveStructureDeclaration(const std::string& name)
 {
-	auto it = this->declaredStructures.find(name);
-	return it != this->declaredStructures.end() ? &it->second : nullptr;
+	Structures& structures = this->MutableStructures();
+	auto it = structures.declaredStructures.find(name);
+	if (it == structures.declaredStructures.end()) {
+		return nullptr;
+	}
+
+	// The declaration may be edited through the pointer, so tuples parsed
+	// from here on get a layout of their own
+	structures.tupleLayouts.erase(name);
+	return &it->second;
 }
 
 const std::unordered_map<std::string, hrtds::StructureLayout>& hrtds::HRTDS::GetDeclaredStructures() const
 {
-	return this->declaredStructures;
+	return this->SharedStructures().declaredStructures;
 }
 
 const std::vector<std::string>& hrtds::HRTDS::GetStructureOrder() const
 {
-	return this->structureOrder;
+	return this->SharedStructures().structureOrder;
+}
+
+std::shared_ptr<const hrtds::TupleLayout> hrtds::HRTDS::GetTupleLayout(const std::string& name) const
+{
+	const std::unordered_map<std::string, std::shared_ptr<const TupleLayout>>& tupleLayouts = this->SharedStructures().tupleLayouts;
+	auto it = tupleLayouts.find(name);
+	return it != tupleLayouts.end() ? it->second : nullptr;
 }
 
 void hrtds::HRTDS::DefineField(const std::string& name, Value&& value)
 {
-	this->fields[name] = std::move(value);
-	this->fieldOrder.push_back(name);
+	Fields& fields = this->MutableFields();
+	fields.fields[name] = std::move(value);
+	fields.fieldOrder.push_back(name);
 }
 
 hrtds::Value* hrtds::HRTDS::RetrieveFieldDefinition(const std::string& name)
 {
-	auto it = this->fields.find(name);
-	return it != this->fields.end() ? &it->second : nullptr;
+	Fields& fields = this->MutableFields();
+	auto it = fields.fields.find(name);
+	return it != fields.fields.end() ? &it->second : nullptr;
+}
+
+hrtds::Value hrtds::HRTDS::MakeArray(const std::string& identifier, size_t reserve) const
+{
+	Identifier resolved = identifier.empty() ? Identifier(false) : Identifier::Determine(identifier, *this);
+	if (!resolved.isValid() || !resolved.isArray()) {
+		throw std::invalid_argument("'" + identifier + "' is not an array of a built-in type or a declared struct.");
+	}
+
+	Value array = Value();
+	array.SetIdentifier(resolved);
+	array.MutableChildren().reserve(reserve);
+	return array;
+}
+
+hrtds::Value hrtds::HRTDS::MakeTuple(const std::string& structure) const
+{
+	std::shared_ptr<const TupleLayout> layout = this->GetTupleLayout(structure);
+	if (layout == nullptr) {
+		auto it = this->GetDeclaredStructures().find(structure);
+		if (it == this->GetDeclaredStructures().end()) {
+			throw std::invalid_argument("There is no struct named '" + structure + "'.");
+		}
+
+		layout = TupleLayout::Create(it->second);
+	}
+
+	Value tuple = Value();
+	tuple.SetIdentifier(Identifier::Determine(structure, *this));
+
+	// Every field starts out empty and typed after its layout element
+	const std::vector<LayoutElement>& elements = layout->layout.GetLayoutElements();
+	std::vector<Value>& children = tuple.MutableChildren();
+	children.reserve(elements.size());
+	for (const LayoutElement& element : elements)
+	{
+		Value child = Value();
+		child.SetIdentifier(element.identifier);
+		children.push_back(std::move(child));
+	}
+
+	tuple.SetLayout(std::move(layout));
+	return tuple;
+}
+
+hrtds::Value& hrtds::HRTDS::AddField(const std::string& name, Value&& value)
+{
+	if (this->GetFields().count(name)) {
+		throw std::invalid_argument("There is a field named '" + name + "' already.");
+	}
+
+	value.CheckComplete();
+	this->DefineField(name, std::move(value));
+	return *this->RetrieveFieldDefinition(name);
 }
 
 hrtds::Value& hrtds::HRTDS::operator[](const std::string& name)
 {
-	return this->fields[name];
+	return this->MutableFields().fields[name];
+}
+
+const hrtds::Value& hrtds::HRTDS::operator[](const std::string& name) const
+{
+	return this->SharedFields().fields.at(name);
+}
+
+size_t hrtds::HRTDS::GetSchemaStructureCount() const
+{
+	return this->SharedStructures().schemaStructures;
 }
 
 const std::unordered_map<std::string, hrtds::Value>& hrtds::HRTDS::GetFields() const
 {
-	return this->fields;
+	return this->SharedFields().fields;
 }
 
 const std::vector<std::string>& hrtds::HRTDS::GetFieldOrder() const
 {
-	return this->fieldOrder;
+	return this->SharedFields().fieldOrder;
+}
+
+hrtds::HRTDS hrtds::HRTDS::Clone() const
+{
+	HRTDS clone;
+	clone.structures = this->structures;
+	clone.fields = this->fields;
+	clone.internPool = this->internPool;
+	clone.identifierNames = this->identifierNames;
+
+	return clone;
+}
+
+hrtds::HRTDS::Structures& hrtds::HRTDS::MutableStructures()
+{
+	if (this->structures == nullptr) {
+		this->structures = std::make_shared<Structures>();
+	}
+	else if (this->structures.use_count() > 1) {
+		this->structures = std::make_shared<Structures>(*this->structures);
+	}
+
+	return *this->structures;
+}
+
+hrtds::HRTDS::Fields& hrtds::HRTDS::MutableFields()
+{
+	if (this->fields == nullptr) {
+		this->fields = std::make_shared<Fields>();
+	}
+	else if (this->fields.use_count() > 1) {
+		// Every value is cloned, which only shares their children
+		std::shared_ptr<Fields> detached = std::make_shared<Fields>();
+		detached->fieldOrder = this->fields->fieldOrder;
+		detached->fields.reserve(this->fields->fields.size());
+		for (const auto& [name, value] : this->fields->fields)
+		{
+			detached->fields.emplace(name, value.Clone());
+		}
+
+		this->fields = std::move(detached);
+	}
+
+	return *this->fields;
+}
+
+const hrtds::HRTDS::Structures& hrtds::HRTDS::SharedStructures() const
+{
+	static const Structures empty;
+	return this->structures != nullptr ? *this->structures : empty;
+}
+
+const hrtds::HRTDS::Fields& hrtds::HRTDS::SharedFields() const
+{
+	static const Fields empty;
+	return this->fields != nullptr ? *this->fields : empty;
+}
+
+void hrtds::HRTDS::MarkSchemaStructures()
+{
+	Structures& structures = this->MutableStructures();
+	structures.schemaStructures = structures.structureOrder.size();
 }
 
 void hrtds::HRTDS::Parse(HRTDS& hrtds, std::string content)
 {
+	ParseScratch scratch;
+	HRTDS::ParseContent(hrtds, content, false, scratch);
+}
+
+void hrtds::HRTDS::Parse(HRTDS& hrtds, std::string_view content, ParseScratch& scratch)
+{
+	HRTDS::ParseContent(hrtds, content, false, scratch);
+}
+
+void hrtds::HRTDS::Parse(HRTDS& hrtds, std::string_view content, const Schema& schema)
+{
+	ParseScratch scratch;
+	HRTDS::Parse(hrtds, content, schema, scratch);
+}
+
+void hrtds::HRTDS::Parse(HRTDS& hrtds, std::string_view content, const Schema& schema, ParseScratch& scratch)
+{
+	// Declaring a struct in the document copies the table (see MutableStructures())
+	hrtds.structures = schema.GetDeclarations().structures;
+	HRTDS::ParseContent(hrtds, content, false, scratch);
+}
+
+void hrtds::HRTDS::ParseBorrowed(HRTDS& hrtds, std::string_view content)
+{
+	ParseScratch scratch;
+	HRTDS::ParseContent(hrtds, content, true, scratch);
+}
+
+void hrtds::HRTDS::DetachStrings()
+{
+	for (auto& [name, value] : this->MutableFields().fields)
+	{
+		value.DetachStrings();
+	}
+}
+
+void hrtds::HRTDS::SetInternPool(std::shared_ptr<InternPool> pool)
+{
+	this->internPool = std::move(pool);
+}
+
+const std::shared_ptr<hrtds::InternPool>& hrtds::HRTDS::GetInternPool() const
+{
+	return this->internPool;
+}
+
+std::shared_ptr<const std::string> hrtds::HRTDS::InternIdentifierName(const std::string& name) const
+{
+	const std::shared_ptr<InternPool>& pool = this->internPool != nullptr ? this->internPool : this->identifierNames;
+	if (pool == nullptr) {
+		return std::make_shared<const std::string>(name);
+	}
+
+	// Shares ownership of the pool, the name lives as long as it does
+	return std::shared_ptr<const std::string>(pool, &pool->Intern(name));
+}
+
+uint64_t hrtds::HRTDS::Hash() const
+{
+	uint64_t hash = data::HASH_SEED;
+
+	const Structures& structures = this->SharedStructures();
+	for (const std::string& name : structures.structureOrder)
+	{
+		hash = data::HashCombine(hash, data::HashBytes(name.data(), name.size()));
+
+		auto declared = structures.declaredStructures.find(name);
+		if (declared == structures.declaredStructures.end()) {
+			continue;
+		}
+
+		for (const LayoutElement& element : declared->second.GetLayoutElements())
+		{
+			const std::string& identifierName = element.identifier.GetIdentifierName();
+			hash = data::HashCombine(hash, data::HashBytes(identifierName.data(), identifierName.size()));
+			hash = data::HashCombine(hash, element.identifier.isArray());
+			hash = data::HashCombine(hash, data::HashBytes(element.name.data(), element.name.size()));
+		}
+	}
+
+	const Fields& fields = this->SharedFields();
+	for (const std::string& name : fields.fieldOrder)
+	{
+		hash = data::HashCombine(hash, data::HashBytes(name.data(), name.size()));
+		hash = data::HashCombine(hash, fields.fields.at(name).Hash());
+	}
+
+	return hash;
+}
+
+hrtds::DocumentFootprint hrtds::HRTDS::MemoryReport() const
+{
+	DocumentFootprint report;
+	std::unordered_set<const void*> counted;
+
+	// The layouts are shared by every tuple of their struct, so they are
+	// counted here instead of for the first field using them
+	const Structures& structures = this->SharedStructures();
+	if (this->structures != nullptr) {
+		report.structures.maps += SHARED_BLOCK_SIZE + sizeof(Structures);
+	}
+
+	report.structures.maps += MapBytes(structures.declaredStructures) + MapBytes(structures.tupleLayouts) + VectorBytes(structures.structureOrder);
+	for (const std::string& name : structures.structureOrder)
+	{
+		// The order and both maps each hold a copy of the name
+		report.structures.maps += 3 * StringHeapBytes(name);
+	}
+
+	for (const auto& [name, layout] : structures.declaredStructures)
+	{
+		MeasureStructureLayout(layout, report.structures);
+	}
+
+	for (const auto& [name, layout] : structures.tupleLayouts)
+	{
+		if (counted.insert(layout.get()).second) {
+			MeasureTupleLayout(*layout, report.structures);
+		}
+	}
+
+	const Fields& fields = this->SharedFields();
+	if (this->fields != nullptr) {
+		report.document.maps += SHARED_BLOCK_SIZE + sizeof(Fields);
+	}
+
+	// Every Value lives in a node of the field map, which is counted for
+	// its field instead
+	report.document.maps += MapBytes(fields.fields) - fields.fields.size() * sizeof(Value) + VectorBytes(fields.fieldOrder);
+	for (const std::string& name : fields.fieldOrder)
+	{
+		report.document.maps += 2 * StringHeapBytes(name);
+	}
+
+	report.fields.reserve(fields.fieldOrder.size());
+	for (const std::string& name : fields.fieldOrder)
+	{
+		MemoryFootprint footprint;
+		footprint.nodes += sizeof(Value);
+		fields.fields.at(name).MeasureMemory(footprint, counted);
+
+		report.total += footprint;
+		report.fields.emplace_back(name, footprint);
+	}
+
+	report.total += report.document;
+	report.total += report.structures;
+	return report;
+}
+
+void hrtds::HRTDS::ShrinkToFit()
+{
+	if (this->structures != nullptr && this->structures.use_count() == 1) {
+		this->structures->structureOrder.shrink_to_fit();
+	}
+
+	if (this->fields == nullptr || this->fields.use_count() != 1) {
+		return;
+	}
+
+	this->fields->fieldOrder.shrink_to_fit();
+	this->fields->fields.rehash(0);
+	for (auto& [name, value] : this->fields->fields)
+	{
+		value.ShrinkToFit();
+	}
+}
+
+void hrtds::HRTDS::ParseContent(HRTDS& hrtds, std::string_view source, bool borrowed, ParseScratch& scratch)
+{
+	HRTDS_TRACE_SCOPE("HRTDS::Parse", source.size());
+	HRTDS_TRACE_PHASE(phase, "HRTDS::Parse file scope", source.size());
+
 	// Prepare file
-	size_t fileScopeBeginPos = content.find(config::GlyphLiterals::BEGIN_FILE_SCOPE);
-	if (fileScopeBeginPos == content.npos) {
+	size_t fileScopeBeginPos = source.find(config::GlyphLiterals::BEGIN_FILE_SCOPE);
+	if (fileScopeBeginPos == source.npos) {
 		throw std::runtime_error("The file needs to include a '" + config::GlyphLiterals::BEGIN_FILE_SCOPE + "' to mark the beginning of the file. (The file-begin-marker could not be found)");
 	}
 	fileScopeBeginPos += config::GlyphLiterals::BEGIN_FILE_SCOPE.size();
 
-	size_t fileScopeEndPos = content.rfind(config::GlyphLiterals::END_FILE_SCOPE);
-	if (fileScopeEndPos == content.npos) {
+	size_t fileScopeEndPos = source.rfind(config::GlyphLiterals::END_FILE_SCOPE);
+	if (fileScopeEndPos == source.npos) {
 		throw std::runtime_error("The file needs to include a '" + config::GlyphLiterals::END_FILE_SCOPE + "' to mark the end of the file. (The file-end-marker could not be found)");
 	}
 	
-	content = content.substr(fileScopeBeginPos, (fileScopeEndPos - fileScopeBeginPos));
-	utils::Trim(content);
-
-	// Collect every string
-	std::vector<std::string> stringBank;
+	std::string& content = scratch.content;
+	content.assign(source.substr(fileScopeBeginPos, (fileScopeEndPos - fileScopeBeginPos)));
+
+	HRTDS_TRACE_NEXT(phase, "HRTDS::Parse strings", content.size());
+
+	// Collect every string, as views into 'source'. 'offset' is how far 
+	// ahead 'source' is of 'content', which changes as strings are replaced
+	// (and may wrap around in between, it is only ever added to positions)
+	tokenizer::StringBank& stringBank = scratch.stringBank;
+	stringBank.strings.clear();
+	stringBank.borrowed = borrowed;
+	size_t offset = fileScopeBeginPos;
 	for (size_t i = 0; i < content.size(); i++)
 	{
 		// Locate the string
@@ -842,12 +1702,13 @@ void hrtds::HRTDS::Parse(HRTDS& hrtds, std::string content)
 		}
 
 		// Collect the string
-		std::string collectedString = content.substr(quoteBegin, (quoteEnd - quoteBegin));
-		stringBank.push_back(collectedString);
+		std::string_view collectedString = source.substr(quoteBegin + offset, (quoteEnd - quoteBegin));
+		stringBank.strings.push_back(collectedString);
 
 		// Replace the original string with its index
-		std::string stringIndex = std::to_string(stringBank.size() - 1);
+		std::string stringIndex = std::to_string(stringBank.strings.size() - 1);
 		content.replace(content.begin() + quoteBegin, content.begin() + quoteEnd, stringIndex);
+		offset += collectedString.size() - stringIndex.size();
 
 		// Re-sync cursor (i) position
 		// From "<abc>"___ then "n"______ to "n"______
@@ -855,11 +1716,17 @@ void hrtds::HRTDS::Parse(HRTDS& hrtds, std::string content)
 		i = quoteBegin + stringIndex.size();
 	}
 
+	HRTDS_TRACE_NEXT(phase, "HRTDS::Parse whitespace", content.size());
+
+	utils::Trim(content);
+
 	// Remove all whitesapce (we only want to preserve whitespace inside strings)
 	content.erase(std::remove_if(content.begin(), content.end(), [](char c) { return std::isspace(static_cast<unsigned char>(c)); }), content.end());
 
-	// Tokenize file and repopulate strings
-	std::vector<tokenizer::Token> tokens = tokenizer::Tokenizer::Tokenize(content, stringBank);
+	HRTDS_TRACE_NEXT(phase, "Tokenizer::Tokenize", content.size());
+
+	// Tokenize file, strings stay in the bank until a value claims them
+	tokenizer::Tape tape = tokenizer::Tokenizer::Tokenize(content, stringBank, std::move(scratch.tape), scratch.structureIndex);
 
 	/* Build the HRTDS structure */
 	// This consists of:
@@ -867,148 +1734,66 @@ void hrtds::HRTDS::Parse(HRTDS& hrtds, std::string content)
 	//		2) Declare a struct
 	//		3) ... or declare a defining field
 	//		4) While also verifying the syntax
+	HRTDS_TRACE_NEXT(phase, "HRTDS::Parse fields", tape.size());
 
-	for (size_t i = 0; i < tokens.size(); i++)
+	for (size_t i = 0; i < tape.size(); i = tape[i].close)
 	{
-		// We work from [IDENTIFIER] tokens
-		tokenizer::Token& identifierToken = tokens[i];
-		if (identifierToken.GetTokenType() != tokenizer::TokenType::IDENTIFIER) {
+		// We work from [IDENTIFIER] tokens, skipping over everything else
+		const tokenizer::TapeEntry& identifierEntry = tape[i];
+		if (identifierEntry.tokenType != tokenizer::TokenType::IDENTIFIER) {
 			continue;
 		}
 
 		// Verify that the two following tokens are [DEFINING] and [VALUE], respectively
-		tokenizer::Token& definingToken = tokens[i + 1];
-		if (definingToken.GetTokenType() != tokenizer::TokenType::DEFINING) {
-			throw std::runtime_error("In a field, an identifying token has to be preceeded by a defining one. (Expected tokentype DEFINING, but found " + std::to_string(static_cast<int>(definingToken.GetTokenType())) + ")");
+		const tokenizer::TapeEntry& definingEntry = tape[i + 1];
+		if (definingEntry.tokenType != tokenizer::TokenType::DEFINING) {
+			throw std::runtime_error("In a field, an identifying token has to be preceeded by a defining one. (Expected tokentype DEFINING, but found " + std::to_string(static_cast<int>(definingEntry.tokenType)) + ")");
 		}
 
-		tokenizer::Token& valueToken = tokens[i + 2];
-		if (valueToken.GetTokenType() != tokenizer::TokenType::VALUE) {
-			throw std::runtime_error("In a field, a defining token has to be preceeded by a value one. (Expected tokentype VALUE, but found " + std::to_string(static_cast<int>(valueToken.GetTokenType())) + ")");
+		const tokenizer::TapeEntry& valueEntry = tape[i + 2];
+		if (valueEntry.tokenType != tokenizer::TokenType::VALUE) {
+			throw std::runtime_error("In a field, a defining token has to be preceeded by a value one. (Expected tokentype VALUE, but found " + std::to_string(static_cast<int>(valueEntry.tokenType)) + ")");
 		}
 
-		switch (valueToken.GetValueType())
+		std::string definingString = std::string(tape.GetText(i + 1));
+		switch (valueEntry.valueType)
 		{
 			case tokenizer::ValueType::ARRAY:
 			case tokenizer::ValueType::TUPLE:
 			case tokenizer::ValueType::DATA: {
 				// Define a field
-				std::string identifierString = identifierToken.GetData();
-				Identifier identifier = Identifier::Determine(identifierToken.GetData(), hrtds);
+				std::string identifierString = std::string(tape.GetText(i));
+				Identifier identifier = Identifier::Determine(identifierString, hrtds);
 				if (!identifier.isValid()) {
 					throw std::runtime_error("Unrecognized identifier: '" + identifierString + "'. If you meant to use a custom struct make sure the name matches and the it's declarations exists before the use of it.");
 				}
 
-				hrtds.DefineField(definingToken.GetData(), hrtds::Value::Parse(identifier, valueToken, hrtds));
+				HRTDS_TRACE_SCOPE_DETAIL("Value::Parse", valueEntry.length, definingString);
+
+				bool intern = hrtds.internPool != nullptr && hrtds.internPool->isInternedField(definingString);
+				hrtds.DefineField(definingString, hrtds::Value::Parse(identifier, tape, i + 2, hrtds, intern));
 				break;
 			}
 			
 			case tokenizer::ValueType::SCOPE: {
 				// Define a structure
-				hrtds.DeclareStructure(definingToken.GetData(), hrtds::StructureLayout::Parse(valueToken, hrtds));
+				hrtds.DeclareStructure(definingString, hrtds::StructureLayout::Parse(tape, i + 2, hrtds));
 				break;
 			}
 
 			default: break;
 		}
 	}
+
+	scratch.tape = tape.Release();
 }
 
 std::string hrtds::HRTDS::Compose(const HRTDS& hrtds)
 {
-	std::string composed = std::string()
-		+ config::GlyphLiterals::BEGIN_FILE_SCOPE
-		+ config::Glyph::WHITESPACE_NEWLINE;
-
-	const std::unordered_map<std::string, StructureLayout>& declaredStructures
-		= hrtds.GetDeclaredStructures();
-	const std::vector<std::string> structureOrder = hrtds.GetStructureOrder();
+	return Composer(ComposeMode::PRETTY).Compose(hrtds);
+}
 
-	for (const std::string& structureName : structureOrder)
-	{
-		const auto& structure = declaredStructures.at(structureName);
-
-		std::string structString = std::string()
-			+ config::Glyph::WHITESPACE_TAB
-			+ config::Glyph::IDENTIFIER	 
-			+ config::IdenifierLiterals::STRUCT_IDENTIFIER
-			+ config::Glyph::IDENTIFIER	 
-			+ config::Glyph::WHITESPACE_SPACE
-			+ structureName				 
-			+ config::Glyph::WHITESPACE_SPACE
-			+ config::Glyph::ASSIGNMENT	 
-			+ config::Glyph::WHITESPACE_SPACE
-			+ config::Glyph::BEGIN_SCOPE;
-
-		const StructureLayout& layout = structure;
-		const std::vector<LayoutElement>& elements = layout.GetLayoutElements();
-		for (size_t i = 0; i < elements.size(); i++)
-		{								 
-			const Identifier& identifier = elements[i].identifier;
-			const std::string& fieldName = elements[i].name;
-										 
-			std::string declaringFieldString = std::string()
-				+ config::Glyph::WHITESPACE_NEWLINE
-				+ config::Glyph::WHITESPACE_TAB
-				+ config::Glyph::WHITESPACE_TAB
-				+ config::Glyph::IDENTIFIER
-				+ identifier.GetIdentifierName()
-				+ (identifier.isArray() ? std::string() 
-						+ config::Glyph::BEGIN_ARRAY
-						+ config::Glyph::END_ARRAY 
-				: "")					 
-				+ config::Glyph::IDENTIFIER
-				+ config::Glyph::WHITESPACE_SPACE
-				+ fieldName				 
-				+ (i != elements.size() - 1 ? std::string() 
-						+ config::Glyph::LIST_SEPARATOR 
-				: "");
-										 
-			structString += declaringFieldString;
-		}								 
-										 
-		structString += std::string()	 
-			+ config::Glyph::WHITESPACE_NEWLINE
-			+ config::Glyph::WHITESPACE_TAB
-			+ config::Glyph::END_SCOPE	 
-			+ config::Glyph::TERMINATOR	 
-			+ config::Glyph::WHITESPACE_NEWLINE
-			+ config::Glyph::WHITESPACE_NEWLINE;
-										 
-		composed += structString;		 
-	}									 
-										 
-	const std::unordered_map<std::string, Value>& fields = hrtds.GetFields();
-	const std::vector<std::string>& fieldOrder = hrtds.GetFieldOrder();
-	for (const std::string& fieldName : fieldOrder)
-	{
-		const Value& value = fields.at(fieldName);
-		const Identifier& identifier = value.GetIdentifier();
-		
-		std::string fieldString = std::string()
-			+ config::Glyph::WHITESPACE_TAB
-			+ config::Glyph::IDENTIFIER
-			+ identifier.GetIdentifierName()
-			+ (identifier.isArray() ? std::string()
-					+ config::Glyph::BEGIN_ARRAY
-					+ config::Glyph::END_ARRAY
-			: "")
-			+ config::Glyph::IDENTIFIER
-			+ config::Glyph::WHITESPACE_SPACE
-			+ fieldName
-			+ config::Glyph::WHITESPACE_SPACE
-			+ config::Glyph::ASSIGNMENT
-			+ config::Glyph::WHITESPACE_SPACE
-			+ hrtds::Value::Compose(value, 1)
-			+ config::Glyph::TERMINATOR
-			+ config::Glyph::WHITESPACE_NEWLINE;
-
-		composed += fieldString;
-	}
-
-	composed += std::string()
-		+ config::Glyph::WHITESPACE_NEWLINE
-		+ config::GlyphLiterals::END_FILE_SCOPE;
-
-	return composed;
+std::string hrtds::HRTDS::Compose(const HRTDS& hrtds, ComposeMode mode)
+{
+	return Composer(mode).Compose(hrtds);
 }
\ No newline at end of file
@@ -1,57 +1,140 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_set>
+
 #include ".\data\hrtds_data.h"
+#include ".\data\hrtds_misc.h"
+#include ".\data\hrtds_decimal.h"
+#include ".\data\hrtds_integral.h"
+#include ".\data\hrtds_builtin.h"
+#include ".\hrtds_intern.h"
 
 namespace hrtds {
 	namespace tokenizer {
-		enum class TokenType {
+		enum class TokenType : uint8_t {
 			IDENTIFIER,
 			DEFINING,
 			DECLARING,
 			VALUE,	
 		};
 
-		enum class ValueType {
+		enum class ValueType : uint8_t {
 			SCOPE,
 			ARRAY,
 			TUPLE,
 			DATA
 		};
 
-		class Token {
+		// The strings of a document, cut out before tokenizing so that
+		// their content can't be mistaken for syntax. The views point into
+		// the content given to HRTDS::Parse(..), and whether values copy 
+		// them or keep the views depends on 'borrowed'
+		struct StringBank {
+			std::vector<std::string_view> strings;
+			bool borrowed = false;
+		};
+
+		// One token on the tape, its text is [begin, begin + length) of the
+		// tokenized content. For strings ('quoted') 'begin' is the index of
+		// the string in the StringBank instead.
+		struct TapeEntry {
+			TokenType tokenType = TokenType::IDENTIFIER;
+			ValueType valueType = ValueType::SCOPE;
+			bool quoted = false;
+
+			// The amount of direct children
+			uint32_t children = 0;
+
+			size_t begin = 0;
+			size_t length = 0;
+
+			// The index of the first entry after this one and its children
+			size_t close = 0;
+		};
+
+		// Every glyph of a content which gives it structure, found in one
+		// pass before tokenizing
+		//
+		//	 [ 1 , ( 2 , 3 ) , 4 ]
+		//	 ^-->^---------->^-->^	the chain of the array
+		//	       ^-->^-->^			the chain of the tuple
+		//
+		// An opening glyph links ('next') to the first separator of its
+		// container, every separator to the one after it and the last one
+		// to the closing glyph. Walking the elements of a container never
+		// looks at the content of its children, so every nesting level
+		// reuses the same index and tokenizing stays O(size).
+		class StructureIndex {
+		public:
+			struct Mark {
+				size_t position = 0;
+				size_t next = 0;
+			};
+
+			// Throws if the brackets, parentheses and braces don't match
+			void Build(std::string_view content);
+
+			const Mark& operator[](size_t index) const;
+			size_t size() const;
+
+			// The first mark at or after 'position', searching from 'from'
+			size_t Seek(size_t from, size_t position) const;
+		private:
+			std::vector<Mark> marks;
+		};
+
+		// Every token of a document in one contiguous array, in the order
+		// they appear in. A container is directly followed by its children, 
+		// each of which is followed by its own children:
+		//
+		//	&int32_[]& Version : [1, 0];
+		//
+		//	 index:	0			  1			2		  3		4
+		//			[IDENTIFIER][DEFINING][ARRAY	][DATA][DATA]
+		//			 close: 1	 close: 2  close: 5	 4		5
+		//
+		// so the siblings of an entry are found by following 'close'.
+		class Tape {
 		public:
-			Token() = default;
-			Token(TokenType type) : tokenType(type) {}
-			Token(TokenType type, std::string data) : tokenType(type), data(data) {}
-			~Token() = default;
+			Tape(std::string_view content, const StringBank& stringBank);
 
-			void SetTokenType(TokenType type);
-			TokenType GetTokenType() const;
+			// Reuses the capacity of 'storage' for the entries, Release()
+			// hands it back for the next tape
+			Tape(std::string_view content, const StringBank& stringBank, std::vector<TapeEntry>&& storage);
+			std::vector<TapeEntry> Release();
 
-			void SetValueType(ValueType type);
-			ValueType GetValueType() const;
+			const TapeEntry& operator[](size_t index) const;
+			size_t size() const;
 
-			void AddChild(Token token);
-			std::vector<Token>& GetChildren();
+			// The text of an entry, strings resolved through the StringBank
+			std::string_view GetText(size_t index) const;
 
-			void SetData(const std::string& data);
-			std::string GetData() const;
+			// Whether the text of an entry is a string to be borrowed
+			bool isBorrowed(size_t index) const;
 		private:
-			TokenType tokenType = TokenType::IDENTIFIER;
-			ValueType valueType = ValueType::SCOPE;
+			friend class Tokenizer;
 
-			// Data
-			std::vector<Token> children;
-			std::string data;
+			std::vector<TapeEntry> entries;
+			std::string_view content;
+			const StringBank* stringBank;
 		};
 
 		class Tokenizer {
 		public:
-			static std::vector<Token> Tokenize(const std::string& content, const std::vector<std::string>& stringBank);
+			// The tape refers to both 'content' and 'stringBank'
+			static Tape Tokenize(const std::string& content, const StringBank& stringBank);
+			static Tape Tokenize(const std::string& content, const StringBank& stringBank, std::vector<TapeEntry>&& storage);
+			static Tape Tokenize(const std::string& content, const StringBank& stringBank, std::vector<TapeEntry>&& storage, StructureIndex& index);
 		private:
-			static void TokenizeScope(Token& parent, const std::vector<std::string>& stringBank);
-			static void TokenizeArray(Token& parent, const std::vector<std::string>& stringBank);
-			static void TokenizeTuple(Token& parent, const std::vector<std::string>& stringBank);
-			static void TokenizeData(Token& dataToken, const std::vector<std::string>& stringBank);
+			// 'mark' is the first mark of the index at or after 'begin'
+			static void TokenizeValue(Tape& tape, const StructureIndex& index, size_t begin, size_t length, size_t mark, bool allowScope);
+			static void TokenizeScope(Tape& tape, const StructureIndex& index, size_t parent, size_t mark);
+			static void TokenizeList(Tape& tape, const StructureIndex& index, size_t parent, size_t mark);
+			static void TokenizeData(Tape& tape, size_t entry);
 		};
 	};
 
@@ -63,8 +146,27 @@ namespace hrtds {
 		BUILTIN
 	};
 
+	// How HRTDS::Compose(..) lays out the text
+	//	* PRETTY, indented with tabs and newlines
+	//	* MINIFIED, the smallest text which parses to the same document
+	enum class ComposeMode {
+		PRETTY,
+		MINIFIED
+	};
+
+	// Buffers HRTDS::Parse(..) works in, kept between parses so that they
+	// don't have to be allocated again (one per thread)
+	struct ParseScratch {
+		std::string content;
+		tokenizer::StringBank stringBank;
+		std::vector<tokenizer::TapeEntry> tape;
+		tokenizer::StructureIndex structureIndex;
+	};
+
 	// Used in Identifier::Determine() before defined
 	class HRTDS;
+	class Schema;
+	class Projection;
 
 	//         &int& Age : 32;
 	//  this:---^^^
@@ -72,7 +174,7 @@ namespace hrtds {
 	public:
 		Identifier() = default;
 		Identifier(bool valid) : valid(valid) {};
-		Identifier(IdentifierType type, std::string name) : identifierType(type), name(name), valid(true) {};
+		Identifier(IdentifierType type, std::string name) : identifierType(type), name(Identifier::Name(name)), valid(true) {};
 		Identifier(Identifier&& other) noexcept;
 		Identifier(const Identifier& other);
 		~Identifier() = default;
@@ -83,8 +185,12 @@ namespace hrtds {
 		void SetIdentifierType(IdentifierType type);
 		IdentifierType GetIdentifierType() const;
 
+		// Built-in names point into the converter registry, and identifiers
+		// resolved by Determine(..) share the struct names of their document
+		// (see HRTDS::SetInternPool(..)). Names set here for anything else
+		// are owned by the identifier.
 		void SetIdentifierName(const std::string& name);
-		std::string GetIdentifierName() const;
+		const std::string& GetIdentifierName() const;
 
 		void SetArray(bool array);
 		bool isArray() const;
@@ -92,10 +198,16 @@ namespace hrtds {
 		void SetValid(bool valid);
 		bool isValid() const;
 
+		// Compares the names by address, and by their text only when they
+		// come from different documents
+		bool operator==(const Identifier& other) const;
+
 		static Identifier Determine(std::string identifierString, const HRTDS& hrtds);
 	private:
+		static std::shared_ptr<const std::string> Name(const std::string& name);
+
 		IdentifierType identifierType = IdentifierType::BUILTIN;
-		std::string name = "";
+		std::shared_ptr<const std::string> name;
 		bool array = false;
 		
 		bool valid = false;
@@ -132,11 +244,84 @@ namespace hrtds {
 		std::vector<LayoutElement>& GetLayoutElements();
 		const std::vector<LayoutElement>& GetLayoutElements() const;
 
-		static StructureLayout Parse(tokenizer::Token& valueToken, const HRTDS& hrtds);
+		static StructureLayout Parse(const tokenizer::Tape& tape, size_t valueEntry, const HRTDS& hrtds);
 	private:
 		std::vector<LayoutElement> layout;
 	};
 
+	// The layout of a tuple together with its name lookup, immutable once
+	// created so it can be shared freely. Every tuple of a declared struct
+	// shares the one kept by its HRTDS, so comparing these pointers is
+	// comparing the types of two tuples.
+	struct TupleLayout {
+		StructureLayout layout;
+		std::unordered_map<std::string, int> fieldMap;
+
+		static std::shared_ptr<const TupleLayout> Create(StructureLayout layout);
+	};
+
+	// Used in Value::operator[] before defined
+	class FieldHandle;
+
+	namespace data {
+		// What a scalar handed to the builder (see Value::Append(..)) is
+		// stored as, string literals and views become std::strings
+		template<typename T>
+		struct Stored { using type = T; };
+
+		template<>
+		struct Stored<const char*> { using type = std::string; };
+
+		template<>
+		struct Stored<char*> { using type = std::string; };
+
+		template<>
+		struct Stored<std::string_view> { using type = std::string; };
+	};
+
+	// The bytes a value (or a document) takes up, by what they are spent
+	// on. Containers are estimated from their size and capacity, the way
+	// the standard library lays them out. Identifier names live in the
+	// converter registry or a pool of names, so they are not counted.
+	struct MemoryFootprint {
+		size_t nodes = 0;		// Every Value, and the shared vectors of children
+		size_t slack = 0;		// Capacity of those vectors not holding a Value
+		size_t scalars = 0;		// The data of every scalar other than strings
+		size_t strings = 0;		// Owned strings, borrowed ones are held elsewhere
+		size_t layouts = 0;		// Struct layouts, with their elements and names
+		size_t maps = 0;		// Lookups by name, like the fieldMap of a layout
+
+		size_t Total() const;
+		MemoryFootprint& operator+=(const MemoryFootprint& other);
+	};
+
+	// What HRTDS::MemoryReport() finds, 'total' being the sum of the rest
+	struct DocumentFootprint {
+		MemoryFootprint total;
+
+		// The document's tables of fields
+		MemoryFootprint document;
+
+		// Every declared struct, counted once rather than per tuple
+		MemoryFootprint structures;
+
+		// Every top-level field in order. Children shared between fields
+		// (see Value::Clone()) count for the first field holding them.
+		std::vector<std::pair<std::string, MemoryFootprint>> fields;
+	};
+
+	// Values are shared copy-on-write: Clone() only shares the children
+	// and layout of a value, and the first mutable access to a shared 
+	// value (GetChildren(), operator[], Set(..), ...) copies that single 
+	// level. Editing a clone therefore only copies the path down to the
+	// edited value, while the rest stays shared with the original.
+	//
+	// Whether a level is shared is decided from the use count of its
+	// children, which is only reliable while nothing else clones the value
+	// at the same time. Any number of threads may read (and Clone()) a
+	// value nobody mutates, but a value being mutated must only be touched
+	// by the thread mutating it. Clone it first and hand the clone to the
+	// other threads, like Snapshot does.
 	class Value {
 	public:
 		Value() = default;
@@ -149,6 +334,12 @@ namespace hrtds {
 
 		Value& operator[](size_t index);
 		Value& operator[](const std::string& name);
+		const Value& operator[](size_t index) const;
+		const Value& operator[](const std::string& name) const;
+
+		// Throws if we are not a tuple of the handle's struct
+		Value& operator[](const FieldHandle& handle);
+		const Value& operator[](const FieldHandle& handle) const;
 
 		void SetIdentifier(Identifier identifier);
 		const Identifier& GetIdentifier() const;
@@ -156,14 +347,23 @@ namespace hrtds {
 		std::vector<Value>& GetChildren();
 		const std::vector<Value>& GetChildren() const;
 
-		size_t size();
+		// Replaces every child at once, without handing out a reference to
+		// them like GetChildren() does (see Hash())
+		void SetChildren(std::vector<Value> children);
+
+		size_t size() const;
 
 		void SetLayout(StructureLayout layout);
+		void SetLayout(std::shared_ptr<const TupleLayout> layout);
 		const StructureLayout& GetLayout() const;
+		const std::shared_ptr<const TupleLayout>& GetTupleLayout() const;
 
 		template<typename T>
 		T* Get();
 
+		template<typename T>
+		const T* Get() const;
+
 		const void* Get() const;
 
 		template<typename T>
@@ -171,34 +371,377 @@ namespace hrtds {
 
 		void Set(void* data);
 
-		static hrtds::Value Parse(Identifier& identifier, tokenizer::Token& valueToken, const HRTDS& hrtds);
+		// Strings of a document parsed with HRTDS::ParseBorrowed(..) are
+		// views into the parsed content rather than std::strings, Get<T>()
+		// returns nullptr for them. GetString() works for either kind.
+		void SetBorrowed(std::string_view string);
+		bool isBorrowed() const;
+		std::string_view GetString() const;
+
+		// Turns every borrowed string in this value (and its children) into 
+		// an owned std::string, after which the parsed content may go away
+		void DetachStrings();
+
+		// Tuple fields a Projection didn't select (see HRTDS::Parse(..,
+		// projection)) are skipped: they keep their identifier, but hold
+		// no data, children or layout. Composing, writing or reading them
+		// through a handle or a ColumnarArray throws. Setting the value
+		// (Set(..), SetBorrowed(..), Append(..)) ends it being skipped.
+		void SetSkipped(bool skipped);
+		bool isSkipped() const;
+
+		// O(1) for arrays and tuples, the children are shared until either
+		// copy is mutated. Scalars are duplicated through 
+		// data::DynamicConverter::Duplicate(..)
+		Value Clone() const;
+
+		// Whether the children are currently shared with another clone
+		bool isShared() const;
+
+		// A hash of the identifier and content of this value and of every
+		// value below it, each list hashing the hashes of its children
+		//
+		//	  hash(windows) = H("Window[]", hash(windows[0]), hash(windows[1]))
+		//	  hash(windows[0]) = H("Window", hash(title), hash(pos))
+		//
+		// Computed on the first call and kept until the value is mutated.
+		// Setters (Set(..), Assign(..), SetIdentifier(..), ...) forget the
+		// hash of the value they are called on. A value which handed out a
+		// mutable reference to its insides (GetChildren(), operator[],
+		// Append(..), Get<T>()) never keeps its hash again, as it can't tell
+		// when that reference is written through. Children are only reached
+		// through their parents, so every value above an edit is rehashed,
+		// while the values beside that path answer from their kept hashes.
+		// Parsed and built values (see SetChildren(..)) keep their hashes.
+		// Clones keep the hash of the original.
+		//
+		// Equal values hash equally (a borrowed string like an owned one),
+		// so values with different hashes are known to differ. Equal hashes
+		// differ only by chance, about once in 2^64.
+		uint64_t Hash() const;
+
+		// Building values in code, see HRTDS::MakeArray(..) and MakeTuple(..)
+		//
+		//	hrtds::Value points = document.MakeArray("Vec2[]", 1000);
+		//	for (...) {
+		//		hrtds::Value point = document.MakeTuple("Vec2");
+		//		point.Set(x, 4);
+		//		point.Set(y, 2);
+		//		points.Append(std::move(point));
+		//	}
+		//	document.AddField("Points", std::move(points));
+		//
+		// Scalars are moved into storage the value owns, and every call
+		// checks the type against the identifier (or layout) it goes into,
+		// throwing std::invalid_argument on a mismatch.
+
+		// Replaces the data of a scalar, which has to be of type T
+		template<typename T>
+		void Assign(T value);
+
+		// Arrays only, the value has to be of the element type. A tuple has
+		// to have every field set.
+		template<typename T>
+		Value& Append(T value);
+		Value& Append(Value&& value);
+		void Reserve(size_t count);
+
+		// Tuples only, replaces the field the handle stands for
+		template<typename T>
+		void Set(const FieldHandle& handle, T value);
+		void Set(const FieldHandle& handle, Value&& value);
+
+		// A scalar of type T (with the alias of its StaticConverter<T>)
+		template<typename T>
+		static Value Make(T value);
+
+		// Everything this value holds, its children and layouts included.
+		// Children shared with clones count as if they were our own.
+		MemoryFootprint MemoryUsage() const;
+
+		// Gives back the capacity of every vector of children not holding
+		// a Value, except of those shared with a clone (which would have
+		// to be copied instead)
+		void ShrinkToFit();
+
+		static hrtds::Value Parse(Identifier& identifier, const tokenizer::Tape& tape, size_t valueEntry, const HRTDS& hrtds);
+
+		// With 'intern', strings are taken from the InternPool of 'hrtds'
+		// (borrowed from it, see isBorrowed()). Fields of tuples decide for
+		// themselves, through InternPool::isInternedField(..).
+		static hrtds::Value Parse(Identifier& identifier, const tokenizer::Tape& tape, size_t valueEntry, const HRTDS& hrtds, bool intern);
 		static std::string Compose(const Value& value, int level);
+		static std::string Compose(const Value& value, int level, ComposeMode mode);
 	private:
+		friend class HRTDS;
+
+		// Makes sure we are the only owner of our children
+		void Detach();
+
+		// GetChildren() for edits made right here, which don't hand out a
+		// reference to a child and so leave the hash to be kept again
+		std::vector<Value>& MutableChildren();
+
+		// Destroys the data of a scalar, through data::DynamicConverter
+		void ReleaseData();
+
+		// Throws if a tuple has a field which was never set
+		void CheckComplete() const;
+
+		// Throws unless 'value' may take the place of a value of 'expected'
+		static void CheckIdentifier(const Identifier& expected, const Value& value);
+
+		// Called on every mutation, see Hash()
+		void ForgetHash();
+
+		// Called whenever a mutable reference to a child or to the data
+		// is handed out, after which the hash is never kept
+		void OpenHash();
+
+		// Adds everything below this value, every block in 'counted' 
+		// (shared children and layouts) has been counted already
+		void MeasureMemory(MemoryFootprint& footprint, std::unordered_set<const void*>& counted) const;
+
 		// The identity of this value
 		Identifier identifier;
 
 		// For storing raw data
-		void* data;
+		void* data = nullptr;
+
+		// For a string borrowed from the parsed content, instead of data
+		std::string_view borrowed;
+		bool hasBorrowed = false;
+
+		// See isSkipped()
+		bool skipped = false;
 
 		// For storing a tuple or array
-		std::vector<Value> children;
+		std::shared_ptr<std::vector<Value>> children;
 
-		StructureLayout layout;
-		std::unordered_map<std::string, int> fieldMap;
+		std::shared_ptr<const TupleLayout> layoutInfo;
+
+		// The states of 'hash' which aren't a hash, computed hashes skip them
+		static constexpr uint64_t HASH_NONE = 0;
+		static constexpr uint64_t HASH_OPEN = 1;
+
+		// See Hash(), HASH_NONE until computed. Atomic so that threads
+		// sharing a const document may hash it at the same time.
+		mutable std::atomic<uint64_t> hash = HASH_NONE;
+	};
+
+	// A field of a declared struct, resolved once against the layout the
+	// document keeps for that struct
+	//
+	//	hrtds::FieldHandle title(document, "Window", "title");
+	//	for (const hrtds::Value& window : document["windows"].GetChildren())
+	//		window[title] ...
+	//
+	// Accessing a tuple through a handle is a pointer compare and an index,
+	// instead of hashing the field name on every access. Tuples with a
+	// layout of their own (from another document, or built by hand) are
+	// still accepted after comparing their struct by name.
+	class FieldHandle {
+	public:
+		FieldHandle() = default;
+		FieldHandle(const HRTDS& hrtds, const std::string& structure, const std::string& field);
+
+		const std::string& GetStructureName() const;
+		const LayoutElement& GetLayoutElement() const;
+		size_t GetIndex() const;
+		bool isValid() const;
+
+		// Throws if 'tuple' is not a tuple of our struct
+		void Check(const Value& tuple) const;
+	private:
+		void CheckByName(const Value& tuple) const;
+
+		std::shared_ptr<const TupleLayout> layout;
+		std::string structure;
+		size_t index = 0;
 	};
 
+	// A FieldHandle to a scalar field of type T. Whether the field holds a
+	// T is checked once when resolving the handle, and T has to be a type
+	// with a StaticConverter (through HRTDS_DATA_STATIC_CONVERTER(..)),
+	// which the compiler checks.
+	//
+	//	hrtds::TypedFieldHandle<std::string> title(document, "Window", "title");
+	//	const std::string& text = title.Get(window);
+	//
+	// A field without a T of its own throws std::runtime_error instead:
+	// borrowed and interned strings (read those through Value::GetString(),
+	// or Get(..) a mutable tuple, which turns the string into an owned one)
+	// and fields which hold no data at all.
+	template<typename T>
+	class TypedFieldHandle : public FieldHandle {
+	public:
+		TypedFieldHandle() = default;
+		TypedFieldHandle(const HRTDS& hrtds, const std::string& structure, const std::string& field);
+
+		T& Get(Value& tuple) const;
+		const T& Get(const Value& tuple) const;
+	private:
+		// Throws unless 'field' holds data
+		void Require(const Value& field) const;
+	};
+
+	inline void Value::ForgetHash()
+	{
+		if (this->hash.load(std::memory_order_relaxed) != HASH_OPEN) {
+			this->hash.store(HASH_NONE, std::memory_order_relaxed);
+		}
+	}
+
+	inline void Value::OpenHash()
+	{
+		this->hash.store(HASH_OPEN, std::memory_order_relaxed);
+	}
+
 	template<typename T>
 	inline T* Value::Get()
 	{
+		this->OpenHash();
 		return reinterpret_cast<T*>(this->data);
 	}
 
+	template<typename T>
+	inline const T* Value::Get() const
+	{
+		return reinterpret_cast<const T*>(this->data);
+	}
+
 	template<typename T>
 	inline void Value::Set(T* data) {
-		this->children.clear();
+		this->ForgetHash();
+		this->hasBorrowed = false;
+		this->skipped = false;
+		this->children.reset();
 		this->data = reinterpret_cast<void*>(data);
 	}
 
+	template<typename T>
+	inline void Value::Assign(T value)
+	{
+		using Stored = typename data::Stored<T>::type;
+		const char* alias = data::StaticConverter<Stored>::Alias;
+
+		if (this->identifier.isArray() || this->identifier.GetIdentifierType() != IdentifierType::BUILTIN || this->identifier.GetIdentifierName() != alias) {
+			throw std::invalid_argument("Expected a value of type '" + this->identifier.GetIdentifierName() + (this->identifier.isArray() ? "[]" : "") + "', but got a '" + alias + "'.");
+		}
+
+		Stored* stored = new Stored(std::move(value));
+		this->ForgetHash();
+		this->ReleaseData();
+		this->children.reset();
+		this->hasBorrowed = false;
+		this->skipped = false;
+		this->data = stored;
+	}
+
+	template<typename T>
+	inline Value& Value::Append(T value)
+	{
+		if (!this->identifier.isArray()) {
+			throw std::invalid_argument("Only arrays can be appended to, '" + this->identifier.GetIdentifierName() + "' is not one.");
+		}
+
+		// The element shares the array's (interned) identifier name
+		Value element;
+		element.identifier = this->identifier;
+		element.identifier.SetArray(false);
+		element.Assign(std::move(value));
+
+		std::vector<Value>& children = this->GetChildren();
+		children.push_back(std::move(element));
+		return children.back();
+	}
+
+	template<typename T>
+	inline void Value::Set(const FieldHandle& handle, T value)
+	{
+		handle.Check(*this);
+		this->MutableChildren()[handle.GetIndex()].Assign(std::move(value));
+	}
+
+	template<typename T>
+	inline Value Value::Make(T value)
+	{
+		using Stored = typename data::Stored<T>::type;
+
+		Value scalar;
+		scalar.identifier = Identifier(IdentifierType::BUILTIN, data::StaticConverter<Stored>::Alias);
+		scalar.data = new Stored(std::move(value));
+		return scalar;
+	}
+
+	inline Value& Value::operator[](const FieldHandle& handle)
+	{
+		handle.Check(*this);
+		return this->GetChildren()[handle.GetIndex()];
+	}
+
+	inline const Value& Value::operator[](const FieldHandle& handle) const
+	{
+		handle.Check(*this);
+		return this->GetChildren()[handle.GetIndex()];
+	}
+
+	inline void FieldHandle::Check(const Value& tuple) const
+	{
+		if (tuple.GetTupleLayout() != this->layout || this->layout == nullptr) {
+			this->CheckByName(tuple);
+		}
+	}
+
+	template<typename T>
+	inline TypedFieldHandle<T>::TypedFieldHandle(const HRTDS& hrtds, const std::string& structure, const std::string& field)
+		: FieldHandle(hrtds, structure, field)
+	{
+		const Identifier& identifier = this->GetLayoutElement().identifier;
+		if (identifier.isArray() || identifier.GetIdentifierName() != data::StaticConverter<T>::Alias) {
+			throw std::invalid_argument("The field '" + field + "' of '" + structure + "' is not of type '" + data::StaticConverter<T>::Alias + "'.");
+		}
+	}
+
+	template<typename T>
+	inline T& TypedFieldHandle<T>::Get(Value& tuple) const
+	{
+		Value& field = tuple[*this];
+		if (field.isBorrowed()) {
+			field.DetachStrings();
+		}
+
+		this->Require(field);
+		return *field.template Get<T>();
+	}
+
+	template<typename T>
+	inline const T& TypedFieldHandle<T>::Get(const Value& tuple) const
+	{
+		const Value& field = tuple[*this];
+		this->Require(field);
+		return *field.template Get<T>();
+	}
+
+	template<typename T>
+	inline void TypedFieldHandle<T>::Require(const Value& field) const
+	{
+		if (field.Get() != nullptr) {
+			return;
+		}
+
+		const std::string& name = this->GetLayoutElement().name;
+		if (field.isSkipped()) {
+			throw std::runtime_error("The field '" + name + "' was left out by a Projection.");
+		}
+
+		if (field.isBorrowed()) {
+			throw std::runtime_error("The field '" + name + "' holds a borrowed string rather than a std::string, read it through Value::GetString().");
+		}
+
+		throw std::runtime_error("The field '" + name + "' holds no value.");
+	}
+
 	// The main class, this is the root of the file structure
 	//  
 	//	    <root>
@@ -225,7 +768,7 @@ namespace hrtds {
 		HRTDS(const HRTDS& other) = delete;
 		~HRTDS() = default;
 
-		HRTDS& operator=(HRTDS&& other) noexcept = delete;
+		HRTDS& operator=(HRTDS&& other) noexcept;
 		HRTDS& operator=(const HRTDS& other) = delete;
 
 		void DeclareStructure(const std::string& name, StructureLayout layout);
@@ -233,15 +776,89 @@ namespace hrtds {
 		const std::unordered_map<std::string, StructureLayout>& GetDeclaredStructures() const;
 		const std::vector<std::string>& GetStructureOrder() const;
 
+		// The layout shared by every tuple of the struct 'name' parsed into
+		// this document, nullptr if there is no such struct
+		std::shared_ptr<const TupleLayout> GetTupleLayout(const std::string& name) const;
+		void DeclareStructure(const std::string& name, std::shared_ptr<const TupleLayout> layout);
+
+		// How many structs (at the front of GetStructureOrder()) come from
+		// the Schema the document was parsed with. These are left out when
+		// composing, the reader is expected to have the schema as well.
+		size_t GetSchemaStructureCount() const;
+
 		void DefineField(const std::string& name, Value&& value);
 		Value* RetrieveFieldDefinition(const std::string& name);
 		Value& operator[](const std::string& name);
+		const Value& operator[](const std::string& name) const;
 		const std::unordered_map<std::string, Value>& GetFields() const;
 		const std::vector<std::string>& GetFieldOrder() const;
 
+		// O(1), both documents share every structure and field until one
+		// of them is mutated (see hrtds::Value)
+		HRTDS Clone() const;
+
+		// A hash of the declared structs and of every field, its name and
+		// Value::Hash(), in order. Only the fields' hashes are kept, so this
+		// is cheap to call again after an edit to a single field.
+		uint64_t Hash() const;
+
 		static void Parse(HRTDS& hrtds, std::string content);
+		static void Parse(HRTDS& hrtds, std::string_view content, ParseScratch& scratch);
+
+		// Parses with the structs of 'schema' already declared, replacing
+		// any structs 'hrtds' had. The schema's layouts are shared rather
+		// than copied, until the document declares a struct of its own.
+		static void Parse(HRTDS& hrtds, std::string_view content, const Schema& schema);
+		static void Parse(HRTDS& hrtds, std::string_view content, const Schema& schema, ParseScratch& scratch);
+
+		// Parses only what 'projection' selects (see hrtds::Projection).
+		// Fields which aren't selected are skipped by matching brackets,
+		// and are never tokenized or converted. Tuple fields which aren't
+		// selected are left as skipped values (see Value::isSkipped()).
+		// Composing such a document throws.
+		static void Parse(HRTDS& hrtds, std::string_view content, const Projection& projection);
+
+		// Parses like Parse(..), but every string value is a view into 
+		// 'content' instead of a copy (see Value::isBorrowed()). 'content'
+		// has to outlive the document, every clone of it and every value
+		// taken out of it, unless DetachStrings() is called first.
+		static void ParseBorrowed(HRTDS& hrtds, std::string_view content);
+
+		// Turns every borrowed string of the document into an owned one
+		void DetachStrings();
+
+		// Strings of the pool's opted-in fields are interned into it while
+		// parsing into this document. They are borrowed from the pool, which
+		// the document (and its clones) keep alive. A pool may be shared
+		// by any number of documents. The names of declared structs are
+		// interned into it as well, and into a pool of the document's own
+		// while none is set.
+		void SetInternPool(std::shared_ptr<InternPool> pool);
+		const std::shared_ptr<InternPool>& GetInternPool() const;
+
+		// Values to build with (see Value::Append(..)), resolved against the
+		// structs of this document. 'identifier' is written like in a
+		// document, "Vec2[]" for an array of Vec2.
+		Value MakeArray(const std::string& identifier, size_t reserve = 0) const;
+		Value MakeTuple(const std::string& structure) const;
+
+		// Defines a new field, throws if there is one named 'name' already
+		template<typename T>
+		Value& AddField(const std::string& name, T value);
+		Value& AddField(const std::string& name, Value&& value);
+
+		// The bytes the document takes up, per top-level field
+		DocumentFootprint MemoryReport() const;
+
+		// Value::ShrinkToFit() for every field, and the same for the 
+		// document's own tables. Tables shared with a clone are left alone.
+		void ShrinkToFit();
 		static std::string Compose(const HRTDS& hrtds);
+		static std::string Compose(const HRTDS& hrtds, ComposeMode mode);
 	private:
+		friend class Schema;
+		friend class Identifier;
+
 		// Association associates "this" with "these"
 		// 
 		// these:-----------------------|
@@ -253,10 +870,47 @@ namespace hrtds {
 		//		&int& Version;		<---|
 		//		&string& Download;	<---|
 		//	};
-		std::unordered_map<std::string, StructureLayout> declaredStructures;
-		std::vector<std::string> structureOrder;
+		struct Structures {
+			std::unordered_map<std::string, StructureLayout> declaredStructures;
+			std::vector<std::string> structureOrder;
+			std::unordered_map<std::string, std::shared_ptr<const TupleLayout>> tupleLayouts;
+			size_t schemaStructures = 0;
+		};
+
+		struct Fields {
+			std::unordered_map<std::string, Value> fields;
+			std::vector<std::string> fieldOrder;
+		};
 
-		std::unordered_map<std::string, Value> fields;
-		std::vector<std::string> fieldOrder;
+		// Copy-on-write access, these copy the table if it is shared. The
+		// first edit after a Clone() therefore costs O(fields), cloning
+		// every field (which is O(1) each), later edits are free again.
+		Structures& MutableStructures();
+		Fields& MutableFields();
+
+		const Structures& SharedStructures() const;
+		const Fields& SharedFields() const;
+
+		// Every struct declared so far counts as coming from a schema
+		void MarkSchemaStructures();
+
+		static void ParseContent(HRTDS& hrtds, std::string_view source, bool borrowed, ParseScratch& scratch);
+
+		// 'name' as the identifiers of the document hold it, interned into
+		// the InternPool or, without one, into identifierNames
+		std::shared_ptr<const std::string> InternIdentifierName(const std::string& name) const;
+
+		std::shared_ptr<Structures> structures;
+		std::shared_ptr<Fields> fields;
+		std::shared_ptr<InternPool> internPool;
+
+		// The names of the declared structs, created by DeclareStructure(..)
+		std::shared_ptr<InternPool> identifierNames;
 	};
+
+	template<typename T>
+	inline Value& HRTDS::AddField(const std::string& name, T value)
+	{
+		return this->AddField(name, Value::Make(std::move(value)));
+	}
 };
\ No newline at end of file
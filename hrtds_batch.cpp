@@ -0,0 +1,187 @@
+#include "hrtds_batch.h"
+
+#include <algorithm>
+
+hrtds::BatchParser::BatchParser(size_t threadCount)
+	: threadCount(threadCount != 0 ? threadCount : std::max<size_t>(std::thread::hardware_concurrency(), 1))
+{
+	this->shares = std::make_unique<Share[]>(this->threadCount);
+	this->scratches = std::make_unique<ParseScratch[]>(this->threadCount);
+
+	// Worker 0 is whichever thread calls Parse(..)
+	this->threads.reserve(this->threadCount - 1);
+	for (size_t worker = 1; worker < this->threadCount; worker++)
+	{
+		this->threads.emplace_back(&BatchParser::Run, this, worker);
+	}
+}
+
+hrtds::BatchParser::~BatchParser()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+
+	this->wake.notify_all();
+	for (std::thread& thread : this->threads)
+	{
+		thread.join();
+	}
+}
+
+std::vector<hrtds::BatchResult> hrtds::BatchParser::Parse(std::span<const std::string_view> contents)
+{
+	return this->ParseBatch(contents, nullptr);
+}
+
+std::vector<hrtds::BatchResult> hrtds::BatchParser::Parse(std::span<const std::string> contents)
+{
+	std::vector<std::string_view> views(contents.begin(), contents.end());
+	return this->ParseBatch(views, nullptr);
+}
+
+std::vector<hrtds::BatchResult> hrtds::BatchParser::Parse(std::span<const std::string_view> contents, const Schema& schema)
+{
+	return this->ParseBatch(contents, &schema);
+}
+
+std::vector<hrtds::BatchResult> hrtds::BatchParser::Parse(std::span<const std::string> contents, const Schema& schema)
+{
+	std::vector<std::string_view> views(contents.begin(), contents.end());
+	return this->ParseBatch(views, &schema);
+}
+
+std::vector<hrtds::BatchResult> hrtds::BatchParser::ParseBatch(std::span<const std::string_view> contents, const Schema* schema)
+{
+	std::lock_guard<std::mutex> batchLock(this->batchMutex);
+
+	std::vector<BatchResult> results(contents.size());
+	if (contents.empty()) {
+		return results;
+	}
+
+	// Hand every worker an equal share
+	size_t shareSize = (contents.size() + this->threadCount - 1) / this->threadCount;
+	for (size_t worker = 0; worker < this->threadCount; worker++)
+	{
+		Share& share = this->shares[worker];
+		std::lock_guard<std::mutex> lock(share.mutex);
+		share.begin = std::min(worker * shareSize, contents.size());
+		share.end = std::min(share.begin + shareSize, contents.size());
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->batch = { contents, results.data(), schema };
+		this->running = this->threads.size();
+		this->generation++;
+	}
+
+	this->wake.notify_all();
+	this->Work(0);
+
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->done.wait(lock, [this] { return this->running == 0; });
+	this->batch = {};
+
+	return results;
+}
+
+size_t hrtds::BatchParser::GetThreadCount() const
+{
+	return this->threadCount;
+}
+
+void hrtds::BatchParser::Run(size_t worker)
+{
+	uint64_t seen = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->wake.wait(lock, [&] { return this->stopping || this->generation != seen; });
+			if (this->stopping) {
+				return;
+			}
+
+			seen = this->generation;
+		}
+
+		this->Work(worker);
+
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (--this->running == 0) {
+			this->done.notify_all();
+		}
+	}
+}
+
+void hrtds::BatchParser::Work(size_t worker)
+{
+	ParseScratch& scratch = this->scratches[worker];
+
+	size_t index = 0;
+	while (this->Next(worker, index))
+	{
+		BatchResult& result = this->batch.results[index];
+		try {
+			if (this->batch.schema != nullptr) {
+				HRTDS::Parse(result.document, this->batch.contents[index], *this->batch.schema, scratch);
+			}
+			else {
+				HRTDS::Parse(result.document, this->batch.contents[index], scratch);
+			}
+		}
+		catch (const std::exception& exception) {
+			result.document = HRTDS();
+			result.error = std::current_exception();
+			result.message = exception.what();
+		}
+		catch (...) {
+			result.document = HRTDS();
+			result.error = std::current_exception();
+			result.message = "Unknown error.";
+		}
+	}
+}
+
+bool hrtds::BatchParser::Next(size_t worker, size_t& index)
+{
+	Share& own = this->shares[worker];
+	{
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (own.begin < own.end) {
+			index = own.begin++;
+			return true;
+		}
+	}
+
+	// Steal the back half of the first share which has anything left
+	for (size_t offset = 1; offset < this->threadCount; offset++)
+	{
+		Share& victim = this->shares[(worker + offset) % this->threadCount];
+
+		size_t begin = 0;
+		size_t end = 0;
+		{
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			size_t left = victim.end - victim.begin;
+			if (left == 0) {
+				continue;
+			}
+
+			end = victim.end;
+			begin = end - (left + 1) / 2;
+			victim.end = begin;
+		}
+
+		std::lock_guard<std::mutex> lock(own.mutex);
+		own.begin = begin + 1;
+		own.end = end;
+		index = begin;
+		return true;
+	}
+
+	return false;
+}
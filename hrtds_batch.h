@@ -0,0 +1,90 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <span>
+#include <thread>
+
+#include ".\hrtds.h"
+#include ".\hrtds_schema.h"
+
+namespace hrtds {
+	// The outcome of parsing one document of a batch, 'error' (and its
+	// 'message') is set when the document could not be parsed
+	struct BatchResult {
+		HRTDS document;
+		std::exception_ptr error;
+		std::string message;
+
+		explicit operator bool() const { return this->error == nullptr; }
+	};
+
+	// Parses many independent documents at once on a pool of threads
+	//
+	//	   contents:  [0 1 2 3 | 4 5 6 7 | 8 9 10 11]
+	//				   worker 0	 worker 1  worker 2
+	//
+	// Every worker starts on its own share of the batch, and a worker
+	// which runs out takes half of whatever is left of another worker's
+	// share. Small and large documents can therefore be mixed freely.
+	// Each worker keeps its own ParseScratch between documents (and
+	// batches), so parsing a document reuses the buffers of the last one.
+	class BatchParser {
+	public:
+		// 0 picks the hardware concurrency, the thread calling Parse(..)
+		// counts as one of the workers
+		BatchParser(size_t threadCount = 0);
+		BatchParser(const BatchParser& other) = delete;
+		~BatchParser();
+
+		BatchParser& operator=(const BatchParser& other) = delete;
+
+		// The results are in the order of 'contents'. Batches are parsed one
+		// at a time, concurrent calls wait for the previous batch.
+		std::vector<BatchResult> Parse(std::span<const std::string_view> contents);
+		std::vector<BatchResult> Parse(std::span<const std::string> contents);
+
+		// Every document is parsed with 'schema' (see HRTDS::Parse(..))
+		std::vector<BatchResult> Parse(std::span<const std::string_view> contents, const Schema& schema);
+		std::vector<BatchResult> Parse(std::span<const std::string> contents, const Schema& schema);
+
+		size_t GetThreadCount() const;
+	private:
+		// The part of the batch a worker has yet to parse, [begin, end)
+		struct alignas(64) Share {
+			std::mutex mutex;
+			size_t begin = 0;
+			size_t end = 0;
+		};
+
+		struct Batch {
+			std::span<const std::string_view> contents;
+			BatchResult* results = nullptr;
+			const Schema* schema = nullptr;
+		};
+
+		std::vector<BatchResult> ParseBatch(std::span<const std::string_view> contents, const Schema* schema);
+
+		void Run(size_t worker);
+		void Work(size_t worker);
+
+		// The next document for 'worker', taken from its own share or
+		// stolen from another. False once every share is empty.
+		bool Next(size_t worker, size_t& index);
+
+		std::vector<std::thread> threads;
+		std::unique_ptr<Share[]> shares;
+		std::unique_ptr<ParseScratch[]> scratches;
+		size_t threadCount = 0;
+
+		std::mutex batchMutex;
+
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable done;
+		Batch batch;
+		uint64_t generation = 0;
+		size_t running = 0;
+		bool stopping = false;
+	};
+};
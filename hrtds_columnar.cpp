@@ -0,0 +1,367 @@
+#include "hrtds_columnar.h"
+
+#include <type_traits>
+#include <utility>
+
+#include ".\hrtds_composer.h"
+
+namespace {
+	// How a built-in scalar is stored in a primitive column
+	struct ColumnType {
+		std::type_index type;
+		size_t stride;
+		std::shared_ptr<void>(*allocate)(size_t count);
+		void(*copy)(void* element, const void* data);
+		void(*move)(void* element, void* data);
+	};
+
+	template<typename T>
+	ColumnType MakeColumnType()
+	{
+		return ColumnType{
+			typeid(T),
+			sizeof(T),
+			[](size_t count) -> std::shared_ptr<void> { return std::shared_ptr<T[]>(new T[count]()); },
+			[](void* element, const void* data) { *static_cast<T*>(element) = *static_cast<const T*>(data); },
+			[](void* element, void* data) { *static_cast<T*>(element) = std::move(*static_cast<T*>(data)); }
+		};
+	}
+
+	// Every built-in type is stored in a column of its own C++ type
+	const std::unordered_map<std::string, ColumnType>& PrimitiveColumnTypes()
+	{
+		static const std::unordered_map<std::string, ColumnType> types = [] {
+			std::unordered_map<std::string, ColumnType> types;
+			hrtds::data::ForEachBuiltin([&](auto type) {
+				using T = typename decltype(type)::type;
+				types.emplace(hrtds::data::StaticConverter<T>::Alias, MakeColumnType<T>());
+			});
+
+			return types;
+		}();
+
+		return types;
+	}
+
+	// Uninitialized storage for the elements of an in-place type. Only
+	// the first 'constructed' elements are destructed once released, so
+	// whoever constructs them counts them up one by one.
+	struct InPlaceStorage {
+		hrtds::data::InPlaceConverter converter;
+		void* data;
+		size_t constructed = 0;
+
+		InPlaceStorage(const hrtds::data::InPlaceConverter& converter, size_t count)
+			: converter(converter), data(::operator new(converter.size * count, std::align_val_t(converter.alignment))) { }
+
+		~InPlaceStorage()
+		{
+			for (size_t i = 0; i < this->constructed; i++)
+			{
+				this->converter.destruct(static_cast<char*>(this->data) + i * this->converter.size);
+			}
+
+			::operator delete(this->data, std::align_val_t(this->converter.alignment));
+		}
+
+		InPlaceStorage(const InPlaceStorage&) = delete;
+		InPlaceStorage& operator=(const InPlaceStorage&) = delete;
+	};
+
+	// Returns the column storage, which owns 'storage'
+	std::shared_ptr<void> AllocateInPlace(const hrtds::data::InPlaceConverter& converter, size_t count, InPlaceStorage*& storage)
+	{
+		auto owner = std::make_shared<InPlaceStorage>(converter, count);
+		storage = owner.get();
+		return std::shared_ptr<void>(owner, owner->data);
+	}
+}
+
+const hrtds::Identifier& hrtds::Column::GetIdentifier() const
+{
+	return this->identifier;
+}
+
+const std::string& hrtds::Column::GetName() const
+{
+	return this->name;
+}
+
+size_t hrtds::Column::size() const
+{
+	return this->count;
+}
+
+bool hrtds::Column::isPrimitive() const
+{
+	return this->primitive;
+}
+
+const void* hrtds::Column::At(size_t index) const
+{
+	if (index >= this->count) {
+		throw std::out_of_range("Row index out of range for column '" + this->name + "'.");
+	}
+
+	return static_cast<const char*>(this->storage.get()) + index * this->stride;
+}
+
+const hrtds::Value& hrtds::ColumnarArray::Cell::AsValue() const
+{
+	if (this->column->isPrimitive()) {
+		throw std::invalid_argument("The column '" + this->column->GetName() + "' stores plain data, use Get<T>() instead.");
+	}
+
+	return *static_cast<const Value*>(this->column->At(this->index));
+}
+
+const hrtds::Value& hrtds::ColumnarArray::Cell::operator[](size_t index) const
+{
+	return this->AsValue()[index];
+}
+
+const hrtds::Value& hrtds::ColumnarArray::Cell::operator[](const std::string& name) const
+{
+	return this->AsValue()[name];
+}
+
+hrtds::ColumnarArray::Cell hrtds::ColumnarArray::Row::operator[](size_t field) const
+{
+	return Cell(this->array->GetColumn(field), this->index);
+}
+
+hrtds::ColumnarArray::Cell hrtds::ColumnarArray::Row::operator[](const std::string& name) const
+{
+	return Cell(this->array->GetColumn(name), this->index);
+}
+
+hrtds::ColumnarArray::ColumnarArray(const Value& array)
+{
+	this->Build(array);
+}
+
+hrtds::ColumnarArray::ColumnarArray(Value&& array)
+{
+	this->Build(std::move(array));
+}
+
+template<typename ValueReference>
+void hrtds::ColumnarArray::Build(ValueReference&& array)
+{
+	constexpr bool consume = !std::is_const_v<std::remove_reference_t<ValueReference>>;
+
+	const Identifier& identifier = array.GetIdentifier();
+	if (!identifier.isArray() || identifier.GetIdentifierType() != IdentifierType::TUPLE) {
+		throw std::invalid_argument("Only arrays of tuples can be stored as columns.");
+	}
+
+	this->identifier = identifier;
+	this->rows = array.size();
+	if (this->rows == 0) {
+		return;
+	}
+
+	// Every tuple of the array shares the layout of its struct
+	auto& tuples = array.GetChildren();
+	this->layout = tuples[0].GetLayout();
+
+	const std::vector<LayoutElement>& elements = this->layout.GetLayoutElements();
+	for (size_t row = 0; row < this->rows; row++)
+	{
+		if (tuples[row].size() != elements.size()) {
+			throw std::runtime_error("You need to match the amount of elements in tuple to the layout.");
+		}
+
+		// Scalar cells get copied out of their data below, so every one
+		// of them needs some before the first column is constructed
+		const auto& cells = std::as_const(tuples[row]).GetChildren();
+		for (size_t field = 0; field < elements.size(); field++)
+		{
+			if (cells[field].isSkipped()) {
+				throw std::runtime_error("The field '" + elements[field].name + "' of the tuple at " + std::to_string(row) + " was left out by a Projection.");
+			}
+
+			const Identifier& identifier = elements[field].identifier;
+			bool scalar = !identifier.isArray() && identifier.GetIdentifierType() == IdentifierType::BUILTIN;
+			if (scalar && !cells[field].isBorrowed() && cells[field].Get() == nullptr) {
+				throw std::runtime_error("The field '" + elements[field].name + "' of the tuple at " + std::to_string(row) + " holds no value.");
+			}
+		}
+	}
+
+	// In-place columns are constructed element by element below, and
+	// count every element they constructed, in case a later one throws
+	std::vector<InPlaceStorage*> inPlaceColumns(elements.size(), nullptr);
+
+	this->columns.resize(elements.size());
+	for (size_t field = 0; field < elements.size(); field++)
+	{
+		Column& column = this->columns[field];
+		column.identifier = elements[field].identifier;
+		column.name = elements[field].name;
+		column.count = this->rows;
+		this->fieldMap[column.name] = field;
+
+		const Identifier& fieldIdentifier = column.identifier;
+		auto primitiveType = PrimitiveColumnTypes().find(fieldIdentifier.GetIdentifierName());
+		column.primitive = !fieldIdentifier.isArray()
+			&& fieldIdentifier.GetIdentifierType() == IdentifierType::BUILTIN
+			&& primitiveType != PrimitiveColumnTypes().end();
+
+		auto inPlaceType = data::DynamicConverter::InPlace.find(fieldIdentifier.GetIdentifierName());
+		bool inPlace = !column.primitive
+			&& !fieldIdentifier.isArray()
+			&& fieldIdentifier.GetIdentifierType() == IdentifierType::BUILTIN
+			&& inPlaceType != data::DynamicConverter::InPlace.end();
+
+		if (column.primitive) {
+			column.type = primitiveType->second.type;
+			column.stride = primitiveType->second.stride;
+			column.storage = primitiveType->second.allocate(this->rows);
+		}
+		else if (inPlace) {
+			column.primitive = true;
+			column.type = inPlaceType->second.type;
+			column.stride = inPlaceType->second.size;
+			column.storage = AllocateInPlace(inPlaceType->second, this->rows, inPlaceColumns[field]);
+		}
+		else {
+			column.type = typeid(Value);
+			column.stride = sizeof(Value);
+			column.storage = std::shared_ptr<Value[]>(new Value[this->rows]());
+		}
+	}
+
+	for (size_t row = 0; row < this->rows; row++)
+	{
+		auto& tuple = tuples[row];
+		for (size_t field = 0; field < elements.size(); field++)
+		{
+			Column& column = this->columns[field];
+			auto& cell = tuple.GetChildren()[field];
+			void* element = static_cast<char*>(column.storage.get()) + row * column.stride;
+
+			if (!column.primitive) {
+				if constexpr (consume) *static_cast<Value*>(element) = std::move(cell);
+				else *static_cast<Value*>(element) = cell.Clone();
+				continue;
+			}
+
+			if (inPlaceColumns[field] != nullptr) {
+				inPlaceColumns[field]->converter.copy(cell.Get(), element);
+				inPlaceColumns[field]->constructed++;
+				continue;
+			}
+
+			if (cell.isBorrowed()) {
+				*static_cast<std::string*>(element) = std::string(cell.GetString());
+				continue;
+			}
+
+			const ColumnType& type = PrimitiveColumnTypes().at(column.identifier.GetIdentifierName());
+			if constexpr (consume) type.move(element, const_cast<void*>(cell.Get()));
+			else type.copy(element, cell.Get());
+		}
+	}
+}
+
+size_t hrtds::ColumnarArray::size() const
+{
+	return this->rows;
+}
+
+const hrtds::Identifier& hrtds::ColumnarArray::GetIdentifier() const
+{
+	return this->identifier;
+}
+
+const hrtds::StructureLayout& hrtds::ColumnarArray::GetLayout() const
+{
+	return this->layout;
+}
+
+hrtds::ColumnarArray::Row hrtds::ColumnarArray::operator[](size_t index) const
+{
+	if (index >= this->rows) {
+		throw std::out_of_range("Row index out of range.");
+	}
+
+	return Row(*this, index);
+}
+
+const std::vector<hrtds::Column>& hrtds::ColumnarArray::GetColumns() const
+{
+	return this->columns;
+}
+
+const hrtds::Column& hrtds::ColumnarArray::GetColumn(size_t field) const
+{
+	return this->columns.at(field);
+}
+
+const hrtds::Column& hrtds::ColumnarArray::GetColumn(const std::string& name) const
+{
+	auto it = this->fieldMap.find(name);
+	if (it == this->fieldMap.end()) {
+		throw std::out_of_range("The layout has no field named '" + name + "'.");
+	}
+
+	return this->columns[it->second];
+}
+
+hrtds::Column& hrtds::ColumnarArray::GetColumn(const std::string& name)
+{
+	return const_cast<Column&>(std::as_const(*this).GetColumn(name));
+}
+
+hrtds::Value hrtds::ColumnarArray::ToValue() const
+{
+	Value array = Value();
+	array.SetIdentifier(this->identifier);
+
+	Identifier tupleIdentifier = this->identifier;
+	tupleIdentifier.SetArray(false);
+
+	// Every row shares one layout, instead of one per row
+	std::shared_ptr<const TupleLayout> tupleLayout = TupleLayout::Create(this->layout);
+
+	std::vector<Value> tuples;
+	tuples.reserve(this->rows);
+	for (size_t row = 0; row < this->rows; row++)
+	{
+		Value tuple = Value();
+		tuple.SetIdentifier(tupleIdentifier);
+
+		std::vector<Value> cells;
+		cells.reserve(this->columns.size());
+		for (const Column& column : this->columns)
+		{
+			if (!column.primitive) {
+				cells.emplace_back(static_cast<const Value*>(column.At(row))->Clone());
+				continue;
+			}
+
+			Value cell = Value();
+			cell.SetIdentifier(column.identifier);
+			cell.Set(data::DynamicConverter::Duplicate(column.identifier.GetIdentifierName(), column.At(row)));
+			cells.emplace_back(std::move(cell));
+		}
+
+		tuple.SetChildren(std::move(cells));
+		tuple.SetLayout(tupleLayout);
+		tuples.emplace_back(std::move(tuple));
+	}
+
+	array.SetChildren(std::move(tuples));
+	return array;
+}
+
+std::string hrtds::ColumnarArray::Compose(const ColumnarArray& array, int level)
+{
+	return Composer(ComposeMode::PRETTY).Compose(array, level);
+}
+
+std::string hrtds::ColumnarArray::Compose(const ColumnarArray& array, int level, ComposeMode mode)
+{
+	return Composer(mode).Compose(array, level);
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <typeindex>
+
+#include ".\hrtds.h"
+
+namespace hrtds {
+	// One field of every tuple in a ColumnarArray, stored contiguously
+	//
+	//	   Window[]						position	title	  ...
+	//	  (pos, size, title, ...)  -->	[pos,		"...",
+	//	  (pos, size, title, ...)		 pos,		"...",
+	//	  (pos, size, title, ...)		 pos]		"..."]
+	//
+	// Built-in scalars (integers, float, double, bool and string) are kept
+	// as a plain array of their C++ type, which Span<T>() exposes. So are
+	// custom types with an in-place converter (see data::InPlaceConverter).
+	// Any other field (arrays, tuples and other custom types) is kept as an
+	// array of Values.
+	class Column {
+	public:
+		const Identifier& GetIdentifier() const;
+		const std::string& GetName() const;
+		size_t size() const;
+
+		// Whether the column is a plain array of a scalar type
+		bool isPrimitive() const;
+
+		// Throws if T is not the type the column is stored as
+		template<typename T>
+		std::span<const T> Span() const;
+
+		template<typename T>
+		std::span<T> Span();
+
+		// The address of an element, which is a T* for primitive columns
+		// and a Value* otherwise
+		const void* At(size_t index) const;
+	private:
+		friend class ColumnarArray;
+
+		Identifier identifier;
+		std::string name;
+
+		std::type_index type = typeid(void);
+		bool primitive = false;
+		size_t stride = 0;
+		size_t count = 0;
+		std::shared_ptr<void> storage;
+	};
+
+	// Arrays of a declared struct, stored as one Column per LayoutElement
+	// rather than as a Value per tuple. Scanning a single field of many
+	// tuples then walks one contiguous array.
+	class ColumnarArray {
+	public:
+		// A single field of a single tuple
+		class Cell {
+		public:
+			template<typename T>
+			const T* Get() const;
+
+			// Only for fields stored as Values (see Column::isPrimitive())
+			const Value& AsValue() const;
+			const Value& operator[](size_t index) const;
+			const Value& operator[](const std::string& name) const;
+		private:
+			friend class ColumnarArray;
+			Cell(const Column& column, size_t index) : column(&column), index(index) {}
+
+			const Column* column;
+			size_t index;
+		};
+
+		// A single tuple, accessed like a Value holding one
+		class Row {
+		public:
+			Cell operator[](size_t field) const;
+			Cell operator[](const std::string& name) const;
+		private:
+			friend class ColumnarArray;
+			Row(const ColumnarArray& array, size_t index) : array(&array), index(index) {}
+
+			const ColumnarArray* array;
+			size_t index;
+		};
+
+		ColumnarArray() = default;
+
+		// 'array' has to be an array of tuples, the rows are copied into
+		// columns (or moved, for the rvalue overload)
+		ColumnarArray(const Value& array);
+		ColumnarArray(Value&& array);
+
+		size_t size() const;
+		const Identifier& GetIdentifier() const;
+		const StructureLayout& GetLayout() const;
+
+		Row operator[](size_t index) const;
+
+		const std::vector<Column>& GetColumns() const;
+		const Column& GetColumn(size_t field) const;
+		const Column& GetColumn(const std::string& name) const;
+		Column& GetColumn(const std::string& name);
+
+		// Shorthand for GetColumn(name).Span<T>()
+		template<typename T>
+		std::span<const T> ColumnSpan(const std::string& name) const;
+
+		// Back to a Value holding one tuple per row
+		Value ToValue() const;
+
+		// Same text as composing ToValue() with Value::Compose(..)
+		static std::string Compose(const ColumnarArray& array, int level);
+		static std::string Compose(const ColumnarArray& array, int level, ComposeMode mode);
+	private:
+		template<typename ValueReference>
+		void Build(ValueReference&& array);
+
+		Identifier identifier;
+		StructureLayout layout;
+		std::unordered_map<std::string, size_t> fieldMap;
+		std::vector<Column> columns;
+		size_t rows = 0;
+	};
+
+	template<typename T>
+	inline std::span<const T> Column::Span() const
+	{
+		if (this->type != std::type_index(typeid(T))) {
+			throw std::invalid_argument("The column '" + this->name + "' is not stored as the requested type.");
+		}
+
+		return std::span<const T>(static_cast<const T*>(this->storage.get()), this->count);
+	}
+
+	template<typename T>
+	inline std::span<T> Column::Span()
+	{
+		if (this->type != std::type_index(typeid(T))) {
+			throw std::invalid_argument("The column '" + this->name + "' is not stored as the requested type.");
+		}
+
+		return std::span<T>(static_cast<T*>(this->storage.get()), this->count);
+	}
+
+	template<typename T>
+	inline const T* ColumnarArray::Cell::Get() const
+	{
+		if (!this->column->isPrimitive()) {
+			return this->AsValue().Get<T>();
+		}
+
+		return &this->column->Span<T>()[this->index];
+	}
+
+	template<typename T>
+	inline std::span<const T> ColumnarArray::ColumnSpan(const std::string& name) const
+	{
+		return this->GetColumn(name).Span<T>();
+	}
+};
\ No newline at end of file
@@ -0,0 +1,648 @@
+#include "hrtds_composer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <climits>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include ".\hrtds_columnar.h"
+#include ".\hrtds_config.h"
+#include ".\hrtds_trace.h"
+
+namespace {
+	// Strings are written straight from the value, only other scalars are
+	// converted (once per pass). Numbers fit in the small string buffer of
+	// the converted text, so converting them doesn't allocate.
+	const std::string* AsString(const hrtds::Identifier& identifier, const void* data)
+	{
+		if (identifier.GetIdentifierName() != hrtds::data::StaticConverter<std::string>::Alias) {
+			return nullptr;
+		}
+
+		return static_cast<const std::string*>(data);
+	}
+
+	std::string ConvertScalar(const hrtds::Identifier& identifier, const void* data)
+	{
+		return hrtds::data::DynamicConverter::ToString.at(identifier.GetIdentifierName())(data);
+	}
+
+	// Sizing pass, counts every character
+	struct MeasureSink {
+		static constexpr const char* TRACE_NAME = "Composer::Measure field";
+
+		size_t size = 0;
+
+		void Append(char) { this->size++; }
+		void Append(size_t count, char) { this->size += count; }
+		void Append(const std::string& string) { this->size += string.size(); }
+
+		void AppendScalar(const hrtds::Identifier& identifier, const void* data)
+		{
+			if (const std::string* string = AsString(identifier, data)) {
+				this->AppendString(*string);
+				return;
+			}
+
+			this->size += ConvertScalar(identifier, data).size();
+		}
+
+		void AppendString(std::string_view string) { this->size += string.size() + 2; }
+	};
+
+	// Writing pass, fills a buffer presized by the sizing pass
+	struct WriteSink {
+		static constexpr const char* TRACE_NAME = "Composer::Write field";
+
+		char* cursor;
+
+		void Append(char character) { *this->cursor++ = character; }
+
+		void Append(size_t count, char character)
+		{
+			std::memset(this->cursor, character, count);
+			this->cursor += count;
+		}
+
+		void Append(const std::string& string)
+		{
+			std::memcpy(this->cursor, string.data(), string.size());
+			this->cursor += string.size();
+		}
+
+		void AppendScalar(const hrtds::Identifier& identifier, const void* data)
+		{
+			if (const std::string* string = AsString(identifier, data)) {
+				this->AppendString(*string);
+				return;
+			}
+
+			this->Append(ConvertScalar(identifier, data));
+		}
+
+		void AppendString(std::string_view string)
+		{
+			this->Append(hrtds::config::Glyph::QUOTE);
+			std::memcpy(this->cursor, string.data(), string.size());
+			this->cursor += string.size();
+			this->Append(hrtds::config::Glyph::QUOTE);
+		}
+	};
+}
+
+hrtds::Composer::Composer(ComposeMode mode)
+	: mode(mode)
+{}
+
+std::string hrtds::Composer::Compose(const HRTDS& hrtds) const
+{
+	HRTDS_TRACE_SCOPE("Composer::Compose", hrtds.GetFieldOrder().size());
+	HRTDS_TRACE_PHASE(phase, "Composer::Compose measure", hrtds.GetFieldOrder().size());
+
+	MeasureSink measure;
+	this->WriteDocument(measure, hrtds);
+
+	HRTDS_TRACE_NEXT(phase, "Composer::Compose write", measure.size);
+
+	std::string composed(measure.size, '\0');
+	WriteSink write = { composed.data() };
+	this->WriteDocument(write, hrtds);
+
+	return composed;
+}
+
+std::string hrtds::Composer::Compose(const Value& value, int level) const
+{
+	MeasureSink measure;
+	this->WriteValue(measure, value, level);
+
+	std::string composed(measure.size, '\0');
+	WriteSink write = { composed.data() };
+	this->WriteValue(write, value, level);
+
+	return composed;
+}
+
+std::string hrtds::Composer::Compose(const ColumnarArray& array, int level) const
+{
+	MeasureSink measure;
+	this->WriteColumnar(measure, array, level);
+
+	std::string composed(measure.size, '\0');
+	WriteSink write = { composed.data() };
+	this->WriteColumnar(write, array, level);
+
+	return composed;
+}
+
+size_t hrtds::Composer::Measure(const HRTDS& hrtds) const
+{
+	MeasureSink measure;
+	this->WriteDocument(measure, hrtds);
+
+	return measure.size;
+}
+
+size_t hrtds::Composer::Measure(const Value& value, int level) const
+{
+	MeasureSink measure;
+	this->WriteValue(measure, value, level);
+
+	return measure.size;
+}
+
+size_t hrtds::Composer::Measure(const ColumnarArray& array, int level) const
+{
+	MeasureSink measure;
+	this->WriteColumnar(measure, array, level);
+
+	return measure.size;
+}
+
+std::string hrtds::Composer::ComposeParallel(const HRTDS& hrtds, size_t threadCount) const
+{
+	std::vector<std::string> pieces = this->ComposeFragments(hrtds, threadCount);
+
+	size_t size = 0;
+	for (const std::string& piece : pieces)
+	{
+		size += piece.size();
+	}
+
+	std::string composed;
+	composed.reserve(size);
+	for (const std::string& piece : pieces)
+	{
+		composed += piece;
+	}
+
+	return composed;
+}
+
+void hrtds::Composer::WriteParallel(const HRTDS& hrtds, const std::string& path, size_t threadCount) const
+{
+	std::vector<std::string> pieces = this->ComposeFragments(hrtds, threadCount);
+
+#if defined(__unix__) || defined(__APPLE__)
+	int descriptor = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (descriptor < 0) {
+		throw std::runtime_error("Could not open '" + path + "' for writing.");
+	}
+
+	std::vector<iovec> vectors;
+	vectors.reserve(pieces.size());
+	for (std::string& piece : pieces)
+	{
+		if (!piece.empty()) {
+			vectors.push_back({ piece.data(), piece.size() });
+		}
+	}
+
+	size_t next = 0;
+	while (next < vectors.size())
+	{
+		int count = static_cast<int>(std::min<size_t>(vectors.size() - next, IOV_MAX));
+		ssize_t written = writev(descriptor, &vectors[next], count);
+		if (written < 0) {
+			close(descriptor);
+			throw std::runtime_error("Could not write to '" + path + "'.");
+		}
+
+		// Skip whatever was written, a short write may end mid-piece
+		size_t remaining = static_cast<size_t>(written);
+		while (next < vectors.size() && remaining >= vectors[next].iov_len)
+		{
+			remaining -= vectors[next].iov_len;
+			next++;
+		}
+
+		if (remaining > 0) {
+			vectors[next].iov_base = static_cast<char*>(vectors[next].iov_base) + remaining;
+			vectors[next].iov_len -= remaining;
+		}
+	}
+
+	close(descriptor);
+#else
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		throw std::runtime_error("Could not open '" + path + "' for writing.");
+	}
+
+	for (const std::string& piece : pieces)
+	{
+		file.write(piece.data(), static_cast<std::streamsize>(piece.size()));
+	}
+#endif
+}
+
+hrtds::ComposeMode hrtds::Composer::GetMode() const
+{
+	return this->mode;
+}
+
+std::vector<hrtds::Composer::Fragment> hrtds::Composer::Fragments(const HRTDS& hrtds) const
+{
+	std::vector<Fragment> fragments;
+	fragments.push_back({ Fragment::Kind::HEADER });
+
+	const std::unordered_map<std::string, Value>& fields = hrtds.GetFields();
+	for (const std::string& fieldName : hrtds.GetFieldOrder())
+	{
+		const Value& value = fields.at(fieldName);
+		size_t size = value.size();
+		if (!value.GetIdentifier().isArray() || size <= Composer::PARALLEL_CHUNK_SIZE) {
+			fragments.push_back({ Fragment::Kind::FIELD, &fieldName, &value });
+			continue;
+		}
+
+		bool expand = this->Expands(value);
+		fragments.push_back({ Fragment::Kind::FIELD_BEGIN, &fieldName, &value, 0, 0, expand });
+		for (size_t begin = 0; begin < size; begin += Composer::PARALLEL_CHUNK_SIZE)
+		{
+			size_t end = std::min(begin + Composer::PARALLEL_CHUNK_SIZE, size);
+			fragments.push_back({ Fragment::Kind::ELEMENTS, &fieldName, &value, begin, end, expand });
+		}
+		fragments.push_back({ Fragment::Kind::FIELD_END, &fieldName, &value, 0, 0, expand });
+	}
+
+	fragments.push_back({ Fragment::Kind::FOOTER });
+	return fragments;
+}
+
+std::vector<std::string> hrtds::Composer::ComposeFragments(const HRTDS& hrtds, size_t threadCount) const
+{
+	std::vector<Fragment> fragments = this->Fragments(hrtds);
+	std::vector<std::string> pieces(fragments.size());
+
+	if (threadCount == 0) {
+		threadCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	}
+	threadCount = std::min(threadCount, fragments.size());
+
+	// Workers take the next fragment until none are left, every piece
+	// is composed with the same two passes as Compose(..)
+	std::atomic<size_t> nextFragment = 0;
+	std::vector<std::exception_ptr> errors(threadCount);
+	auto work = [&](size_t worker) {
+		try {
+			for (size_t i = nextFragment++; i < fragments.size(); i = nextFragment++)
+			{
+				MeasureSink measure;
+				this->WriteFragment(measure, hrtds, fragments[i]);
+
+				pieces[i].resize(measure.size);
+				WriteSink write = { pieces[i].data() };
+				this->WriteFragment(write, hrtds, fragments[i]);
+			}
+		}
+		catch (...) {
+			errors[worker] = std::current_exception();
+			nextFragment = fragments.size();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	workers.reserve(threadCount - 1);
+	for (size_t worker = 1; worker < threadCount; worker++)
+	{
+		workers.emplace_back(work, worker);
+	}
+
+	work(0);
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	for (const std::exception_ptr& error : errors)
+	{
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	return pieces;
+}
+
+template<typename Sink>
+void hrtds::Composer::WriteFragment(Sink& sink, const HRTDS& hrtds, const Fragment& fragment) const
+{
+	switch (fragment.kind)
+	{
+		case Fragment::Kind::HEADER: {
+			this->WriteHeader(sink, hrtds); break;
+		}
+		case Fragment::Kind::FIELD: {
+			this->WriteField(sink, *fragment.name, *fragment.value); break;
+		}
+		case Fragment::Kind::FIELD_BEGIN: {
+			this->WriteFieldBegin(sink, *fragment.name, *fragment.value);
+			this->WriteListBegin(sink, *fragment.value, fragment.expand);
+			break;
+		}
+		case Fragment::Kind::ELEMENTS: {
+			this->WriteListElements(sink, *fragment.value, 1, fragment.begin, fragment.end, fragment.expand); break;
+		}
+		case Fragment::Kind::FIELD_END: {
+			this->WriteListEnd(sink, *fragment.value, 1, fragment.expand);
+			this->WriteFieldEnd(sink);
+			break;
+		}
+		case Fragment::Kind::FOOTER: {
+			this->WriteFooter(sink); break;
+		}
+		default: break;
+	}
+}
+
+template<typename Sink>
+void hrtds::Composer::WriteDocument(Sink& sink, const HRTDS& hrtds) const
+{
+	this->WriteHeader(sink, hrtds);
+
+	const std::unordered_map<std::string, Value>& fields = hrtds.GetFields();
+	for (const std::string& fieldName : hrtds.GetFieldOrder())
+	{
+		this->WriteField(sink, fieldName, fields.at(fieldName));
+	}
+
+	this->WriteFooter(sink);
+}
+
+template<typename Sink>
+void hrtds::Composer::WriteHeader(Sink& sink, const HRTDS& hrtds) const
+{
+	sink.Append(config::GlyphLiterals::BEGIN_FILE_SCOPE);
+	if (this->mode == ComposeMode::PRETTY) sink.Append(config::Glyph::WHITESPACE_NEWLINE);
+
+	// Structs of the schema the document was parsed with are not repeated
+	const std::unordered_map<std::string, StructureLayout>& declaredStructures = hrtds.GetDeclaredStructures();
+	const std::vector<std::string>& structureOrder = hrtds.GetStructureOrder();
+	for (size_t i = hrtds.GetSchemaStructureCount(); i < structureOrder.size(); i++)
+	{
+		this->WriteStructure(sink, structureOrder[i], declaredStructures.at(structureOrder[i]));
+	}
+}
+
+template<typename Sink>
+void hrtds::Composer::WriteFooter(Sink& sink) const
+{
+	if (this->mode == ComposeMode::PRETTY) sink.Append(config::Glyph::WHITESPACE_NEWLINE);
+	sink.Append(config::GlyphLiterals::END_FILE_SCOPE);
+}
+
+template<typename Sink>
+void hrtds::Composer::WriteStructure(Sink& sink, const std::string& name, const StructureLayout& layout) const
+{
+	//	&struct& Version : {
+	//		&float& Date,
+	//		&string& Download
+	//	};
+	bool pretty = this->mode == ComposeMode::PRETTY;
+
+	if (pretty) sink.Append(config::Glyph::WHITESPACE_TAB);
+	sink.Append(config::Glyph::IDENTIFIER);
+	sink.Append(config::IdenifierLiterals::STRUCT_IDENTIFIER);
+	sink.Append(config::Glyph::IDENTIFIER);
+	if (pretty) sink.Append(config::Glyph::WHITESPACE_SPACE);
+	sink.Append(name);
+	if (pretty) sink.Append(config::Glyph::WHITESPACE_SPACE);
+	sink.Append(config::Glyph::ASSIGNMENT);
+	if (pretty) sink.Append(config::Glyph::WHITESPACE_SPACE);
+	sink.Append(config::Glyph::BEGIN_SCOPE);
+
+	const std::vector<LayoutElement>& elements = layout.GetLayoutElements();
+	for (size_t i = 0; i < elements.size(); i++)
+	{
+		if (pretty) {
+			sink.Append(config::Glyph::WHITESPACE_NEWLINE);
+			sink.Append(2, config::Glyph::WHITESPACE_TAB);
+		}
+
+		this->WriteIdentifier(sink, elements[i].identifier);
+		if (pretty) sink.Append(config::Glyph::WHITESPACE_SPACE);
+		sink.Append(elements[i].name);
+
+		if (i != elements.size() - 1) {
+			sink.Append(config::Glyph::LIST_SEPARATOR);
+		}
+	}
+
+	if (pretty) {
+		sink.Append(config::Glyph::WHITESPACE_NEWLINE);
+		sink.Append(config::Glyph::WHITESPACE_TAB);
+	}
+
+	sink.Append(config::Glyph::END_SCOPE);
+	sink.Append(config::Glyph::TERMINATOR);
+
+	if (pretty) sink.Append(2, config::Glyph::WHITESPACE_NEWLINE);
+}
+
+template<typename Sink>
+void hrtds::Composer::WriteField(Sink& sink, const std::string& name, const Value& value) const
+{
+	//	&int32_[]& Version : [1, 0, 0];
+	HRTDS_TRACE_SCOPE_DETAIL(Sink::TRACE_NAME, value.size(), name);
+
+	this->WriteFieldBegin(sink, name, value);
+	this->WriteValue(sink, value, 1);
+	this->WriteFieldEnd(sink);
+}
+
+template<typename Sink>
+void hrtds::Composer::WriteFieldBegin(Sink& sink, const std::string& name, const Value& value) const
+{
+	bool pretty = this->mode == ComposeMode::PRETTY;
+
+	if (pretty) sink.Append(config::Glyph::WHITESPACE_TAB);
+	this->WriteIdentifier(sink, value.GetIdentifier());
+	if (pretty) sink.Append(config::Glyph::WHITESPACE_SPACE);
+	sink.Append(name);
+	if (pretty) sink.Append(config::Glyph::WHITESPACE_SPACE);
+	sink.Append(config::Glyph::ASSIGNMENT);
+	if (pretty) sink.Append(config::Glyph::WHITESPACE_SPACE);
+}
+
+template<typename Sink>
+void hrtds::Composer::WriteFieldEnd(Sink& sink) const
+{
+	sink.Append(config::Glyph::TERMINATOR);
+	if (this->mode == ComposeMode::PRETTY) sink.Append(config::Glyph::WHITESPACE_NEWLINE);
+}
+
+template<typename Sink>
+void hrtds::Composer::WriteIdentifier(Sink& sink, const Identifier& identifier) const
+{
+	sink.Append(config::Glyph::IDENTIFIER);
+	sink.Append(identifier.GetIdentifierName());
+
+	if (identifier.isArray()) {
+		sink.Append(config::Glyph::BEGIN_ARRAY);
+		sink.Append(config::Glyph::END_ARRAY);
+	}
+
+	sink.Append(config::Glyph::IDENTIFIER);
+}
+
+template<typename Sink>
+void hrtds::Composer::WriteValue(Sink& sink, const Value& value, int level) const
+{
+	// There is nothing to write in place of what the file held
+	if (value.isSkipped()) {
+		throw std::runtime_error("A value left out by a Projection can not be composed. (Parse the document with its fields selected)");
+	}
+
+	const Identifier& identifier = value.GetIdentifier();
+	bool isList = identifier.isArray() || identifier.GetIdentifierType() == IdentifierType::TUPLE;
+	if (!isList) {
+		// Borrowed strings are written as they are, without converting
+		if (value.isBorrowed()) sink.AppendString(value.GetString());
+		else sink.AppendScalar(identifier, value.Get());
+		return;
+	}
+
+	bool expand = this->Expands(value);
+	this->WriteListBegin(sink, value, expand);
+	this->WriteListElements(sink, value, level, 0, value.size(), expand);
+	this->WriteListEnd(sink, value, level, expand);
+}
+
+template<typename Sink>
+void hrtds::Composer::WriteColumnar(Sink& sink, const ColumnarArray& array, int level) const
+{
+	bool pretty = this->mode == ComposeMode::PRETTY;
+
+	// Every row has the same layout, so whether the tuples are spread over
+	// multiple lines is decided once by the column types
+	bool expandRows = false;
+	for (const Column& column : array.GetColumns())
+	{
+		const Identifier& identifier = column.GetIdentifier();
+		expandRows |= pretty && (identifier.isArray() || identifier.GetIdentifierType() == IdentifierType::TUPLE);
+	}
+
+	sink.Append(config::Glyph::BEGIN_ARRAY);
+	if (pretty) sink.Append(config::Glyph::WHITESPACE_NEWLINE);
+
+	const std::vector<Column>& columns = array.GetColumns();
+	for (size_t row = 0; row < array.size(); row++)
+	{
+		if (row != 0) {
+			sink.Append(config::Glyph::LIST_SEPARATOR);
+			if (pretty) {
+				sink.Append(config::Glyph::WHITESPACE_SPACE);
+				sink.Append(config::Glyph::WHITESPACE_NEWLINE);
+			}
+		}
+
+		if (pretty) sink.Append(static_cast<size_t>(level + 1), config::Glyph::WHITESPACE_TAB);
+		sink.Append(config::Glyph::BEGIN_TUPLE);
+		if (expandRows) sink.Append(config::Glyph::WHITESPACE_NEWLINE);
+
+		for (size_t field = 0; field < columns.size(); field++)
+		{
+			if (field != 0) {
+				sink.Append(config::Glyph::LIST_SEPARATOR);
+				if (pretty) sink.Append(config::Glyph::WHITESPACE_SPACE);
+				if (expandRows) sink.Append(config::Glyph::WHITESPACE_NEWLINE);
+			}
+
+			if (expandRows) sink.Append(static_cast<size_t>(level + 2), config::Glyph::WHITESPACE_TAB);
+
+			const Column& column = columns[field];
+			if (column.isPrimitive()) {
+				sink.AppendScalar(column.GetIdentifier(), column.At(row));
+			}
+			else {
+				this->WriteValue(sink, *static_cast<const Value*>(column.At(row)), level + 2);
+			}
+		}
+
+		if (expandRows) {
+			sink.Append(config::Glyph::WHITESPACE_NEWLINE);
+			sink.Append(static_cast<size_t>(level + 1), config::Glyph::WHITESPACE_TAB);
+		}
+
+		sink.Append(config::Glyph::END_TUPLE);
+	}
+
+	if (pretty) {
+		sink.Append(config::Glyph::WHITESPACE_NEWLINE);
+		sink.Append(static_cast<size_t>(level), config::Glyph::WHITESPACE_TAB);
+	}
+
+	sink.Append(config::Glyph::END_ARRAY);
+}
+
+template<typename Sink>
+void hrtds::Composer::WriteListBegin(Sink& sink, const Value& value, bool expand) const
+{
+	sink.Append(value.GetIdentifier().isArray() ? config::Glyph::BEGIN_ARRAY : config::Glyph::BEGIN_TUPLE);
+	if (expand) sink.Append(config::Glyph::WHITESPACE_NEWLINE);
+}
+
+template<typename Sink>
+void hrtds::Composer::WriteListElements(Sink& sink, const Value& value, int level, size_t begin, size_t end, bool expand) const
+{
+	bool pretty = this->mode == ComposeMode::PRETTY;
+
+	const std::vector<Value>& children = value.GetChildren();
+	for (size_t i = begin; i < end; i++)
+	{
+		if (i != 0) {
+			sink.Append(config::Glyph::LIST_SEPARATOR);
+			if (pretty) sink.Append(config::Glyph::WHITESPACE_SPACE);
+			if (expand) sink.Append(config::Glyph::WHITESPACE_NEWLINE);
+		}
+
+		if (expand) sink.Append(static_cast<size_t>(level + 1), config::Glyph::WHITESPACE_TAB);
+		this->WriteValue(sink, children[i], level + 1);
+	}
+}
+
+template<typename Sink>
+void hrtds::Composer::WriteListEnd(Sink& sink, const Value& value, int level, bool expand) const
+{
+	if (expand) {
+		sink.Append(config::Glyph::WHITESPACE_NEWLINE);
+		sink.Append(static_cast<size_t>(level), config::Glyph::WHITESPACE_TAB);
+	}
+
+	sink.Append(value.GetIdentifier().isArray() ? config::Glyph::END_ARRAY : config::Glyph::END_TUPLE);
+}
+
+bool hrtds::Composer::Expands(const Value& value) const
+{
+	if (this->mode != ComposeMode::PRETTY) {
+		return false;
+	}
+
+	// Arrays of tuples, and lists holding other lists, are spread over
+	// multiple lines
+	const Identifier& identifier = value.GetIdentifier();
+	if (identifier.isArray() && identifier.GetIdentifierType() == IdentifierType::TUPLE) {
+		return true;
+	}
+
+	for (const Value& child : value.GetChildren())
+	{
+		const Identifier& childIdentifier = child.GetIdentifier();
+		if (childIdentifier.isArray() || childIdentifier.GetIdentifierType() == IdentifierType::TUPLE) {
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include ".\hrtds.h"
+
+namespace hrtds {
+	class ColumnarArray;
+
+	// Turns documents and values back into text, used by HRTDS::Compose(..)
+	// and Value::Compose(..)
+	//
+	// Composing happens in two passes over the same layout code: a sizing
+	// pass which computes the exact length of the output, and a writing
+	// pass which fills a single allocation of that length. Neither keeps
+	// anything per value, scalars other than strings are converted in
+	// both passes instead.
+	class Composer {
+	public:
+		Composer(ComposeMode mode = ComposeMode::PRETTY);
+
+		std::string Compose(const HRTDS& hrtds) const;
+		std::string Compose(const Value& value, int level) const;
+		std::string Compose(const ColumnarArray& array, int level) const;
+
+		// The exact length Compose(..) will produce
+		size_t Measure(const HRTDS& hrtds) const;
+		size_t Measure(const Value& value, int level) const;
+		size_t Measure(const ColumnarArray& array, int level) const;
+
+		// Same output as Compose(..), byte for byte, but the top-level 
+		// fields and chunks of large top-level arrays are composed on
+		// 'threadCount' threads (0 picks the hardware concurrency)
+		std::string ComposeParallel(const HRTDS& hrtds, size_t threadCount = 0) const;
+
+		// Composes like ComposeParallel(..) and writes the pieces straight
+		// to the file at 'path' (with writev where available), without
+		// joining them in memory first
+		void WriteParallel(const HRTDS& hrtds, const std::string& path, size_t threadCount = 0) const;
+
+		ComposeMode GetMode() const;
+
+		// Top-level arrays with more elements than this are split into 
+		// chunks of this many elements when composing in parallel
+		static constexpr size_t PARALLEL_CHUNK_SIZE = 4096;
+	private:
+		// One independently composable piece of a document
+		struct Fragment {
+			enum class Kind {
+				HEADER,			// "${" and every struct declaration
+				FIELD,			// A whole top-level field
+				FIELD_BEGIN,	// A top-level array field up to its first element
+				ELEMENTS,		// The elements [begin, end) of that array
+				FIELD_END,		// The end of that array and field
+				FOOTER			// "}$"
+			};
+
+			Kind kind;
+			const std::string* name = nullptr;
+			const Value* value = nullptr;
+			size_t begin = 0;
+			size_t end = 0;
+			bool expand = false;
+		};
+
+		std::vector<Fragment> Fragments(const HRTDS& hrtds) const;
+		std::vector<std::string> ComposeFragments(const HRTDS& hrtds, size_t threadCount) const;
+
+		template<typename Sink>
+		void WriteFragment(Sink& sink, const HRTDS& hrtds, const Fragment& fragment) const;
+
+		template<typename Sink>
+		void WriteHeader(Sink& sink, const HRTDS& hrtds) const;
+
+		template<typename Sink>
+		void WriteFooter(Sink& sink) const;
+
+		template<typename Sink>
+		void WriteDocument(Sink& sink, const HRTDS& hrtds) const;
+
+		template<typename Sink>
+		void WriteStructure(Sink& sink, const std::string& name, const StructureLayout& layout) const;
+
+		template<typename Sink>
+		void WriteField(Sink& sink, const std::string& name, const Value& value) const;
+
+		template<typename Sink>
+		void WriteFieldBegin(Sink& sink, const std::string& name, const Value& value) const;
+
+		template<typename Sink>
+		void WriteFieldEnd(Sink& sink) const;
+
+		template<typename Sink>
+		void WriteIdentifier(Sink& sink, const Identifier& identifier) const;
+
+		template<typename Sink>
+		void WriteValue(Sink& sink, const Value& value, int level) const;
+
+		// Written exactly like the array of tuples the columns came from
+		template<typename Sink>
+		void WriteColumnar(Sink& sink, const ColumnarArray& array, int level) const;
+
+		// A list is written as begin, elements [begin, end) and end, so 
+		// that large lists can be split up
+		template<typename Sink>
+		void WriteListBegin(Sink& sink, const Value& value, bool expand) const;
+
+		template<typename Sink>
+		void WriteListElements(Sink& sink, const Value& value, int level, size_t begin, size_t end, bool expand) const;
+
+		template<typename Sink>
+		void WriteListEnd(Sink& sink, const Value& value, int level, bool expand) const;
+
+		// Whether a list is spread over multiple lines
+		bool Expands(const Value& value) const;
+
+		ComposeMode mode;
+	};
+};
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "hrtds_incremental.h"
+
+#include <cctype>
+#include <stdexcept>
+
+#include ".\hrtds_config.h"
+
+hrtds::IncrementalParser::IncrementalParser()
+{
+	// Runs up to the first time it needs input
+	this->task = this->Run();
+}
+
+hrtds::IncrementalParser::~IncrementalParser()
+{
+	if (this->task.handle) {
+		this->task.handle.destroy();
+	}
+}
+
+bool hrtds::IncrementalParser::Feed(std::string_view chunk)
+{
+	if (this->task.handle.done()) {
+		if (this->task.handle.promise().exception != nullptr) {
+			std::rethrow_exception(this->task.handle.promise().exception);
+		}
+
+		// Trailing whitespace (the newline after the marker, say) may
+		// still arrive in a chunk of its own
+		for (char character : chunk)
+		{
+			if (!std::isspace(static_cast<unsigned char>(character))) {
+				throw std::runtime_error("The document is already finished. (Found content after the file-end-marker)");
+			}
+		}
+
+		this->remainder.append(chunk);
+		return true;
+	}
+
+	this->chunk = chunk;
+	this->task.handle.resume();
+	this->chunk = {};
+
+	if (this->task.handle.promise().exception != nullptr) {
+		std::rethrow_exception(this->task.handle.promise().exception);
+	}
+
+	return this->task.handle.done();
+}
+
+bool hrtds::IncrementalParser::isFinished() const
+{
+	return this->task.handle.done() && this->task.handle.promise().exception == nullptr;
+}
+
+const hrtds::HRTDS& hrtds::IncrementalParser::GetDocument() const
+{
+	return this->document;
+}
+
+hrtds::HRTDS hrtds::IncrementalParser::Release()
+{
+	return std::move(this->document);
+}
+
+const std::string& hrtds::IncrementalParser::GetRemainder() const
+{
+	return this->remainder;
+}
+
+void hrtds::IncrementalParser::Parse(HRTDS& hrtds, std::istream& stream, size_t chunkSize)
+{
+	if (chunkSize == 0) {
+		throw std::invalid_argument("The chunk size needs to be at least 1.");
+	}
+
+	IncrementalParser parser;
+	std::string chunk(chunkSize, '\0');
+	while (!parser.isFinished())
+	{
+		// read(..) waits for a full chunk, or for the end of the stream
+		// which leaves a shorter one behind
+		stream.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+		std::streamsize received = stream.gcount();
+		if (received == 0) {
+			throw std::runtime_error("The file needs to include a '" + config::GlyphLiterals::END_FILE_SCOPE + "' to mark the end of the file. (The stream ended before the file-end-marker)");
+		}
+
+		parser.Feed(std::string_view(chunk.data(), static_cast<size_t>(received)));
+	}
+
+	hrtds = parser.Release();
+}
+
+hrtds::IncrementalParser::Task hrtds::IncrementalParser::Run()
+{
+	const std::string& beginMarker = config::GlyphLiterals::BEGIN_FILE_SCOPE;
+	const std::string& endMarker = config::GlyphLiterals::END_FILE_SCOPE;
+
+	// Everything received so far, of which [0, start) is already parsed
+	std::string text;
+	size_t start = 0;
+
+	// Wait for the file-begin-marker
+	size_t begin = text.npos;
+	while (begin == text.npos)
+	{
+		text.append(co_await NextChunk{ this });
+		begin = text.find(beginMarker);
+	}
+	start = begin + beginMarker.size();
+
+	// Then one statement at a time, each ending at a ';' outside of a
+	// string. 'scanned' is how far the current one was searched already.
+	size_t scanned = start;
+	bool inString = false;
+	while (true)
+	{
+		// The file-end-marker can only come where a statement would begin
+		if (scanned == start) {
+			size_t first = start;
+			while (first < text.size() && std::isspace(static_cast<unsigned char>(text[first]))) first++;
+
+			size_t available = text.size() - first;
+			if (available >= endMarker.size() && text.compare(first, endMarker.size(), endMarker) == 0) {
+				this->remainder = text.substr(first + endMarker.size());
+				co_return;
+			}
+
+			// Nothing yet, or a '}' which may still turn into "}$"
+			if (available < endMarker.size() && endMarker.compare(0, available, text, first, available) == 0) {
+				text.erase(0, start);
+				start = 0;
+				scanned = 0;
+				text.append(co_await NextChunk{ this });
+				continue;
+			}
+		}
+
+		size_t terminator = text.npos;
+		for (; scanned < text.size(); scanned++)
+		{
+			char current = text[scanned];
+			if (current == config::Glyph::QUOTE) {
+				inString = !inString;
+			}
+			else if (!inString && current == config::Glyph::TERMINATOR) {
+				terminator = scanned;
+				break;
+			}
+		}
+
+		if (terminator == text.npos) {
+			// Drop what is parsed before taking more in
+			scanned -= start;
+			text.erase(0, start);
+			start = 0;
+			text.append(co_await NextChunk{ this });
+			continue;
+		}
+
+		this->ParseStatement(std::string_view(text).substr(start, terminator + 1 - start));
+		start = terminator + 1;
+		scanned = start;
+	}
+}
+
+void hrtds::IncrementalParser::ParseStatement(std::string_view statement)
+{
+	// The statement on its own is a document which adds to ours
+	this->statement.assign(config::GlyphLiterals::BEGIN_FILE_SCOPE);
+	this->statement.append(statement);
+	this->statement.append(config::GlyphLiterals::END_FILE_SCOPE);
+
+	HRTDS::Parse(this->document, this->statement, this->scratch);
+}
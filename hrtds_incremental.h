@@ -0,0 +1,80 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <istream>
+#include <string_view>
+
+#include ".\hrtds.h"
+
+namespace hrtds {
+	// Parses a document while it is still arriving, chunk by chunk
+	//
+	//	   Feed("${ &int32_& a : 1; &Win")		-->  'a' is parsed
+	//	   Feed("dow& w : (1, 2); }")			-->  'w' is parsed
+	//	   Feed("$")							-->  finished
+	//
+	// The parser is a coroutine which suspends whenever it runs out of
+	// input, and is resumed by the next Feed(..). Every top-level field
+	// (and struct) is parsed as soon as its ';' arrives, so the fields
+	// received so far can be used before the rest of the document.
+	class IncrementalParser {
+	public:
+		IncrementalParser();
+		IncrementalParser(const IncrementalParser& other) = delete;
+		~IncrementalParser();
+
+		IncrementalParser& operator=(const IncrementalParser& other) = delete;
+
+		// Parses as much of the document as the chunks so far allow, and
+		// returns whether the file-end-marker has arrived. Parsing errors
+		// are thrown (again by every later call), and end the parser. Once
+		// finished, only whitespace may still be fed.
+		bool Feed(std::string_view chunk);
+		bool isFinished() const;
+
+		// Holds every field parsed so far
+		const HRTDS& GetDocument() const;
+		HRTDS Release();
+
+		// Whatever was fed after the file-end-marker
+		const std::string& GetRemainder() const;
+
+		// Reads 'stream' (a file, a pipe, ...) as its content arrives, 
+		// parsing it along the way
+		static void Parse(HRTDS& hrtds, std::istream& stream, size_t chunkSize = 4096);
+	private:
+		struct Task {
+			struct promise_type {
+				std::exception_ptr exception;
+
+				Task get_return_object() { return Task{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+				std::suspend_never initial_suspend() noexcept { return {}; }
+				std::suspend_always final_suspend() noexcept { return {}; }
+				void return_void() {}
+				void unhandled_exception() { this->exception = std::current_exception(); }
+			};
+
+			std::coroutine_handle<promise_type> handle;
+		};
+
+		// Suspends Run() until Feed(..) resumes it with the next chunk
+		struct NextChunk {
+			IncrementalParser* parser;
+
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<>) const noexcept {}
+			std::string_view await_resume() const noexcept { return this->parser->chunk; }
+		};
+
+		Task Run();
+		void ParseStatement(std::string_view statement);
+
+		Task task;
+		std::string_view chunk;
+		std::string remainder;
+
+		HRTDS document;
+		std::string statement;
+		ParseScratch scratch;
+	};
+};
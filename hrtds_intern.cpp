@@ -0,0 +1,33 @@
+#include "hrtds_intern.h"
+
+const std::string& hrtds::InternPool::Intern(std::string_view string)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	auto it = this->strings.find(string);
+	if (it == this->strings.end()) {
+		it = this->strings.emplace(string).first;
+	}
+
+	return *it;
+}
+
+size_t hrtds::InternPool::size() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->strings.size();
+}
+
+void hrtds::InternPool::InternField(const std::string& name)
+{
+	this->fields.insert(name);
+}
+
+bool hrtds::InternPool::isInternedField(const std::string& name) const
+{
+	return this->fields.find(name) != this->fields.end();
+}
+
+bool hrtds::InternPool::hasInternedFields() const
+{
+	return !this->fields.empty();
+}
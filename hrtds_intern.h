@@ -0,0 +1,46 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace hrtds {
+	// Keeps a single copy of every string handed to it
+	//
+	//	   Intern("active")  --+
+	//	                       +-->  "active"	(one copy, one address)
+	//	   Intern("active")  --+
+	//
+	// Interned strings never move and live as long as the pool, so two
+	// strings of the same pool are equal exactly when their addresses
+	// are. Interning is safe from several threads at once.
+	//
+	// A pool set on a document (HRTDS::SetInternPool(..)) interns the
+	// strings of every field opted in through InternField(..) when the
+	// document is parsed, and the names of its declared structs.
+	class InternPool {
+	public:
+		InternPool() = default;
+		InternPool(const InternPool& other) = delete;
+
+		InternPool& operator=(const InternPool& other) = delete;
+
+		const std::string& Intern(std::string_view string);
+		size_t size() const;
+
+		// Strings of top-level fields and struct fields named 'name' are
+		// interned. Opt every field in before parsing with the pool.
+		void InternField(const std::string& name);
+		bool isInternedField(const std::string& name) const;
+		bool hasInternedFields() const;
+	private:
+		struct Hash {
+			using is_transparent = void;
+			size_t operator()(std::string_view string) const { return std::hash<std::string_view>()(string); }
+		};
+
+		mutable std::mutex mutex;
+		std::unordered_set<std::string, Hash, std::equal_to<>> strings;
+		std::unordered_set<std::string> fields;
+	};
+};
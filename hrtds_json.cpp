@@ -0,0 +1,745 @@
+#include "hrtds_json.h"
+
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+#include ".\hrtds_config.h"
+
+namespace {
+	// Writes the data of a built-in value as a JSON literal, the digits
+	// into 'scratch'
+	using LiteralWriter = std::string_view(*)(const void* data, char (&scratch)[64]);
+
+	template<typename T>
+	std::string_view WriteLiteral(const void* data, char (&scratch)[64])
+	{
+		const T& value = *static_cast<const T*>(data);
+		if constexpr (std::is_same_v<T, bool>) {
+			return value ? "true" : "false";
+		}
+		else {
+			// JSON has no representation for infinities and NaN
+			if constexpr (std::is_floating_point_v<T>) {
+				if (!std::isfinite(value)) return "null";
+			}
+
+			std::to_chars_result written = std::to_chars(scratch, scratch + sizeof(scratch), value);
+			return std::string_view(scratch, written.ptr - scratch);
+		}
+	}
+
+	// Every built-in type which JSON has a literal for. Strings and custom
+	// types are written as strings.
+	const std::unordered_map<std::string, LiteralWriter>& LiteralWriters()
+	{
+		static const std::unordered_map<std::string, LiteralWriter> writers = [] {
+			std::unordered_map<std::string, LiteralWriter> writers;
+			hrtds::data::ForEachBuiltin([&](auto type) {
+				using T = typename decltype(type)::type;
+				if constexpr (std::is_arithmetic_v<T>) {
+					writers.emplace(hrtds::data::StaticConverter<T>::Alias, &WriteLiteral<T>);
+				}
+			});
+
+			return writers;
+		}();
+
+		return writers;
+	}
+
+	// A character as it is written inside a JSON string. Control
+	// characters without a short form become \u00XX, everything else
+	// (UTF-8 included) is written as it is.
+	std::string_view Escape(const char& character, char (&scratch)[6])
+	{
+		switch (character)
+		{
+			case '\"': return "\\\"";
+			case '\\': return "\\\\";
+			case '\n': return "\\n";
+			case '\r': return "\\r";
+			case '\t': return "\\t";
+			case '\b': return "\\b";
+			case '\f': return "\\f";
+			default: break;
+		}
+
+		if (static_cast<unsigned char>(character) >= 0x20) {
+			return std::string_view(&character, 1);
+		}
+
+		static constexpr char HEX[] = "0123456789abcdef";
+		scratch[0] = '\\';
+		scratch[1] = 'u';
+		scratch[2] = '0';
+		scratch[3] = '0';
+		scratch[4] = HEX[(character >> 4) & 0xF];
+		scratch[5] = HEX[character & 0xF];
+		return std::string_view(scratch, sizeof(scratch));
+	}
+
+	// 'name' as a quoted JSON string
+	std::string Quote(std::string_view name)
+	{
+		char scratch[6];
+		std::string quoted;
+		quoted.push_back(hrtds::config::Glyph::QUOTE);
+		for (const char& character : name)
+		{
+			quoted.append(Escape(character, scratch));
+		}
+		quoted.push_back(hrtds::config::Glyph::QUOTE);
+
+		return quoted;
+	}
+
+	// An identifier resolved once, so values can be written without
+	// looking anything up
+	struct ResolvedType {
+		bool array = false;
+
+		// Index into Transcoding::layouts for tuples, -1 otherwise
+		int layout = -1;
+
+		// Scalars with a JSON literal only, converted by their type
+		const std::string* alias = nullptr;
+		LiteralWriter literal = nullptr;
+	};
+
+	// A field of a struct, with its JSON key ("name") escaped up front
+	struct ResolvedElement {
+		ResolvedType type;
+		std::string key;
+	};
+
+	// The text being transcoded, either all of it at once or a stream
+	// read a block at a time
+	class Input {
+	public:
+		Input(std::string_view content)
+			: window(content)
+		{}
+
+		Input(std::istream& stream)
+			: stream(&stream), block(new char[hrtds::JsonTranscoder::BUFFER_SIZE])
+		{}
+
+		// The next character, -1 once the input is exhausted
+		int Peek()
+		{
+			if (this->cursor == this->window.size() && !this->Fill()) {
+				return -1;
+			}
+
+			return static_cast<unsigned char>(this->window[this->cursor]);
+		}
+
+		void Skip()
+		{
+			this->cursor++;
+		}
+
+		size_t GetOffset() const
+		{
+			return this->consumed + this->cursor;
+		}
+	private:
+		bool Fill()
+		{
+			if (this->stream == nullptr) {
+				return false;
+			}
+
+			this->consumed += this->window.size();
+			this->stream->read(this->block.get(), static_cast<std::streamsize>(hrtds::JsonTranscoder::BUFFER_SIZE));
+			this->window = std::string_view(this->block.get(), static_cast<size_t>(this->stream->gcount()));
+			this->cursor = 0;
+
+			return !this->window.empty();
+		}
+
+		std::string_view window;
+		size_t cursor = 0;
+		size_t consumed = 0;
+
+		std::istream* stream = nullptr;
+		std::unique_ptr<char[]> block;
+	};
+
+	class Transcoding {
+	public:
+		Transcoding(Input& input, std::string& buffer, const hrtds::JsonTranscoder::Sink& sink, hrtds::ComposeMode mode)
+			: input(input), buffer(buffer), sink(sink), pretty(mode == hrtds::ComposeMode::PRETTY)
+		{}
+
+		// Starts out with the structs of 'schema' declared
+		void Adopt(const hrtds::Schema& schema);
+
+		void Run();
+		void Flush();
+	private:
+		[[noreturn]] void Fail(size_t offset, const char* message) const;
+
+		// The next character which is not whitespace
+		int Peek();
+		void Expect(char glyph, const char* message);
+
+		// Reads up to (not including) 'stop', returning the text with its
+		// whitespace removed
+		void ReadUntil(char stop, std::string& text, const char* message);
+
+		ResolvedType Resolve(const std::string& identifierString, size_t offset);
+		ResolvedType Resolve(const hrtds::Identifier& identifier) const;
+
+		void Structure(const std::string& name);
+		void Field(const ResolvedType& type, int level);
+		void Element(const ResolvedType& type, int level);
+		void Scalar(const ResolvedType& type);
+
+		void Append(char character);
+		void Append(size_t count, char character);
+		void Append(std::string_view string);
+		void AppendEscaped(const char& character);
+		void AppendKey(std::string_view key);
+		void Newline(int level);
+
+		Input& input;
+		std::string& buffer;
+		const hrtds::JsonTranscoder::Sink& sink;
+		bool pretty;
+
+		// Only the declarations are kept around, to resolve identifiers
+		hrtds::HRTDS declarations;
+		std::vector<std::vector<ResolvedElement>> layouts;
+		std::unordered_map<std::string, int> layoutIndices;
+
+		// Reused by every scalar which is not streamed
+		std::string scalar;
+	};
+
+	void Transcoding::Adopt(const hrtds::Schema& schema)
+	{
+		const hrtds::HRTDS& schemaDeclarations = schema.GetDeclarations();
+		const std::unordered_map<std::string, hrtds::StructureLayout>& declaredStructures = schemaDeclarations.GetDeclaredStructures();
+		for (const std::string& name : schemaDeclarations.GetStructureOrder())
+		{
+			std::vector<ResolvedElement> resolved;
+			for (const hrtds::LayoutElement& element : declaredStructures.at(name).GetLayoutElements())
+			{
+				resolved.push_back({ this->Resolve(element.identifier), Quote(element.name) });
+			}
+
+			this->declarations.DeclareStructure(name, schema.GetTupleLayout(name));
+			this->layoutIndices[name] = static_cast<int>(this->layouts.size());
+			this->layouts.push_back(std::move(resolved));
+		}
+	}
+
+	void Transcoding::Run()
+	{
+		// Anything before the file-begin-marker is skipped, like HRTDS::Parse(..) does
+		while (true)
+		{
+			int current = this->input.Peek();
+			if (current == -1) {
+				this->Fail(this->input.GetOffset(), "The file-begin-marker could not be found.");
+			}
+
+			this->input.Skip();
+			if (current == hrtds::config::GlyphLiterals::BEGIN_FILE_SCOPE[0] && this->input.Peek() == hrtds::config::GlyphLiterals::BEGIN_FILE_SCOPE[1]) {
+				this->input.Skip();
+				break;
+			}
+		}
+
+		this->Append(hrtds::config::Glyph::BEGIN_SCOPE);
+
+		std::string identifierString;
+		std::string name;
+		bool first = true;
+		while (true)
+		{
+			int next = this->Peek();
+			if (next == hrtds::config::GlyphLiterals::END_FILE_SCOPE[0]) {
+				this->input.Skip();
+				if (this->input.Peek() != hrtds::config::GlyphLiterals::END_FILE_SCOPE[1]) {
+					this->Fail(this->input.GetOffset(), "The file-end-marker could not be found.");
+				}
+
+				this->input.Skip();
+				break;
+			}
+
+			if (next == -1) {
+				this->Fail(this->input.GetOffset(), "The file-end-marker could not be found.");
+			}
+
+			// [Identifier] (&...&)
+			this->Expect(hrtds::config::Glyph::IDENTIFIER, "Expected a '&' to begin the identifier of a field.");
+			size_t identifierOffset = this->input.GetOffset();
+			this->ReadUntil(hrtds::config::Glyph::IDENTIFIER, identifierString, "Expected a '&' to end the identifier of a field.");
+			this->input.Skip();
+
+			// [Defining] (&...:)
+			this->ReadUntil(hrtds::config::Glyph::ASSIGNMENT, name, "Expected a ':' after the name of a field.");
+			this->input.Skip();
+
+			// [Value] (:...;)
+			if (identifierString == hrtds::config::IdenifierLiterals::STRUCT_IDENTIFIER) {
+				this->Structure(name);
+			}
+			else {
+				ResolvedType type = this->Resolve(identifierString, identifierOffset);
+
+				if (!first) this->Append(hrtds::config::Glyph::LIST_SEPARATOR);
+				this->Newline(1);
+				this->AppendKey(name);
+				this->Field(type, 1);
+				first = false;
+			}
+
+			this->Expect(hrtds::config::Glyph::TERMINATOR, "Expected a ';' to terminate the field.");
+		}
+
+		if (!first) this->Newline(0);
+		this->Append(hrtds::config::Glyph::END_SCOPE);
+	}
+
+	void Transcoding::Fail(size_t offset, const char* message) const
+	{
+		throw std::runtime_error(std::string(message) + " (At byte " + std::to_string(offset) + ")");
+	}
+
+	int Transcoding::Peek()
+	{
+		int current = this->input.Peek();
+		while (current != -1 && std::isspace(current))
+		{
+			this->input.Skip();
+			current = this->input.Peek();
+		}
+
+		return current;
+	}
+
+	void Transcoding::Expect(char glyph, const char* message)
+	{
+		if (this->Peek() != glyph) {
+			this->Fail(this->input.GetOffset(), message);
+		}
+
+		this->input.Skip();
+	}
+
+	void Transcoding::ReadUntil(char stop, std::string& text, const char* message)
+	{
+		text.clear();
+		for (int current = this->input.Peek(); current != -1; current = this->input.Peek())
+		{
+			if (current == stop) {
+				return;
+			}
+
+			switch (current)
+			{
+				case hrtds::config::Glyph::IDENTIFIER:
+				case hrtds::config::Glyph::ASSIGNMENT:
+				case hrtds::config::Glyph::TERMINATOR:
+				case hrtds::config::Glyph::QUOTE:
+				case hrtds::config::Glyph::BEGIN_SCOPE:
+				case hrtds::config::Glyph::END_SCOPE:
+				case hrtds::config::Glyph::LIST_SEPARATOR: {
+					this->Fail(this->input.GetOffset(), message);
+				}
+				default: break;
+			}
+
+			if (!std::isspace(current)) {
+				text.push_back(static_cast<char>(current));
+			}
+
+			this->input.Skip();
+		}
+
+		this->Fail(this->input.GetOffset(), message);
+	}
+
+	ResolvedType Transcoding::Resolve(const std::string& identifierString, size_t offset)
+	{
+		if (identifierString.empty()) {
+			this->Fail(offset, "Unrecognized identifier.");
+		}
+
+		hrtds::Identifier identifier = hrtds::Identifier::Determine(identifierString, this->declarations);
+		if (!identifier.isValid()) {
+			this->Fail(offset, "Unrecognized identifier.");
+		}
+
+		return this->Resolve(identifier);
+	}
+
+	ResolvedType Transcoding::Resolve(const hrtds::Identifier& identifier) const
+	{
+		ResolvedType type;
+		type.array = identifier.isArray();
+		if (identifier.GetIdentifierType() == hrtds::IdentifierType::TUPLE) {
+			type.layout = this->layoutIndices.at(identifier.GetIdentifierName());
+			return type;
+		}
+
+		const auto& writers = LiteralWriters();
+		auto it = writers.find(identifier.GetIdentifierName());
+		if (it != writers.end()) {
+			type.alias = &identifier.GetIdentifierName();
+			type.literal = it->second;
+		}
+
+		return type;
+	}
+
+	void Transcoding::Structure(const std::string& name)
+	{
+		//	{ &...& ..., &...& ... }
+		this->Expect(hrtds::config::Glyph::BEGIN_SCOPE, "Expected a '{' to begin the struct declaration.");
+
+		hrtds::StructureLayout layout;
+		std::vector<ResolvedElement> resolved;
+		std::string identifierString;
+		std::string elementName;
+		while (true)
+		{
+			this->Expect(hrtds::config::Glyph::IDENTIFIER, "Expected a '&' to begin the identifier of a declaring field.");
+			size_t identifierOffset = this->input.GetOffset();
+			this->ReadUntil(hrtds::config::Glyph::IDENTIFIER, identifierString, "Expected a '&' to end the identifier of a declaring field.");
+			this->input.Skip();
+
+			// The name runs until the next ',' or '}'
+			elementName.clear();
+			for (int current = this->Peek(); current != hrtds::config::Glyph::LIST_SEPARATOR && current != hrtds::config::Glyph::END_SCOPE; current = this->Peek())
+			{
+				if (current == -1 || current == hrtds::config::Glyph::IDENTIFIER || current == hrtds::config::Glyph::TERMINATOR) {
+					this->Fail(this->input.GetOffset(), "Expected a ',' or '}' after the name of a declaring field.");
+				}
+
+				elementName.push_back(static_cast<char>(current));
+				this->input.Skip();
+			}
+
+			if (elementName.empty()) {
+				this->Fail(this->input.GetOffset(), "Expected the name of a declaring field.");
+			}
+
+			// The key is quoted once, every tuple of the struct reuses it
+			ResolvedType type = this->Resolve(identifierString, identifierOffset);
+			layout.AddLayoutElement({ hrtds::Identifier::Determine(identifierString, this->declarations), elementName });
+			resolved.push_back({ type, Quote(elementName) });
+
+			bool end = this->Peek() == hrtds::config::Glyph::END_SCOPE;
+			this->input.Skip();
+			if (end) {
+				break;
+			}
+		}
+
+		this->declarations.DeclareStructure(name, std::move(layout));
+		this->layoutIndices[name] = static_cast<int>(this->layouts.size());
+		this->layouts.push_back(std::move(resolved));
+	}
+
+	void Transcoding::Field(const ResolvedType& type, int level)
+	{
+		if (!type.array) {
+			this->Element(type, level);
+			return;
+		}
+
+		//	[ ..., ..., ... ]  -->  [ ..., ..., ... ]
+		this->Expect(hrtds::config::Glyph::BEGIN_ARRAY, "Expected a '[' to begin the array.");
+		this->Append(hrtds::config::Glyph::BEGIN_ARRAY);
+
+		if (this->Peek() == hrtds::config::Glyph::END_ARRAY) {
+			this->input.Skip();
+			this->Append(hrtds::config::Glyph::END_ARRAY);
+			return;
+		}
+
+		while (true)
+		{
+			this->Newline(level + 1);
+			this->Element(type, level + 1);
+
+			if (this->Peek() == hrtds::config::Glyph::END_ARRAY) {
+				this->input.Skip();
+				break;
+			}
+
+			this->Expect(hrtds::config::Glyph::LIST_SEPARATOR, "Expected a ',' or ']' after an array element.");
+			this->Append(hrtds::config::Glyph::LIST_SEPARATOR);
+		}
+
+		this->Newline(level);
+		this->Append(hrtds::config::Glyph::END_ARRAY);
+	}
+
+	void Transcoding::Element(const ResolvedType& type, int level)
+	{
+		if (type.layout < 0) {
+			this->Scalar(type);
+			return;
+		}
+
+		//	( ..., ..., ... )  -->  { "...": ..., "...": ..., "...": ... }
+		const std::vector<ResolvedElement>& layout = this->layouts[type.layout];
+		this->Expect(hrtds::config::Glyph::BEGIN_TUPLE, "Expected a '(' to begin the tuple.");
+		this->Append(hrtds::config::Glyph::BEGIN_SCOPE);
+
+		for (size_t i = 0; i < layout.size(); i++)
+		{
+			if (i != 0) {
+				if (this->Peek() == hrtds::config::Glyph::END_TUPLE) {
+					this->Fail(this->input.GetOffset(), "The tuple has fewer elements than its layout.");
+				}
+
+				this->Expect(hrtds::config::Glyph::LIST_SEPARATOR, "Expected a ',' between tuple elements.");
+				this->Append(hrtds::config::Glyph::LIST_SEPARATOR);
+			}
+
+			this->Newline(level + 1);
+			this->Append(layout[i].key);
+			this->Append(hrtds::config::Glyph::ASSIGNMENT);
+			if (this->pretty) this->Append(hrtds::config::Glyph::WHITESPACE_SPACE);
+			this->Field(layout[i].type, level + 1);
+		}
+
+		if (this->Peek() == hrtds::config::Glyph::LIST_SEPARATOR) {
+			this->Fail(this->input.GetOffset(), "The tuple has more elements than its layout.");
+		}
+
+		this->Expect(hrtds::config::Glyph::END_TUPLE, "Expected a ')' to end the tuple.");
+		this->Newline(level);
+		this->Append(hrtds::config::Glyph::END_SCOPE);
+	}
+
+	void Transcoding::Scalar(const ResolvedType& type)
+	{
+		size_t offset = this->input.GetOffset();
+		bool quoted = this->Peek() == hrtds::config::Glyph::QUOTE;
+
+		// Strings are streamed, however long they are
+		if (quoted && type.literal == nullptr) {
+			this->input.Skip();
+			this->Append(hrtds::config::Glyph::QUOTE);
+			for (int current = this->input.Peek(); current != hrtds::config::Glyph::QUOTE; current = this->input.Peek())
+			{
+				if (current == -1) {
+					this->Fail(offset, "Could not find the closing quotationmark of a string.");
+				}
+
+				char character = static_cast<char>(current);
+				this->AppendEscaped(character);
+				this->input.Skip();
+			}
+
+			this->input.Skip();
+			this->Append(hrtds::config::Glyph::QUOTE);
+			return;
+		}
+
+		this->scalar.clear();
+		if (quoted) {
+			this->input.Skip();
+			for (int current = this->input.Peek(); current != hrtds::config::Glyph::QUOTE; current = this->input.Peek())
+			{
+				if (current == -1) {
+					this->Fail(offset, "Could not find the closing quotationmark of a string.");
+				}
+
+				this->scalar.push_back(static_cast<char>(current));
+				this->input.Skip();
+			}
+
+			this->input.Skip();
+		}
+		else {
+			for (int current = this->input.Peek(); current != -1; current = this->input.Peek())
+			{
+				if (current == hrtds::config::Glyph::LIST_SEPARATOR || current == hrtds::config::Glyph::END_TUPLE ||
+					current == hrtds::config::Glyph::END_ARRAY || current == hrtds::config::Glyph::TERMINATOR) {
+					break;
+				}
+
+				switch (current)
+				{
+					case hrtds::config::Glyph::BEGIN_SCOPE:
+					case hrtds::config::Glyph::BEGIN_ARRAY:
+					case hrtds::config::Glyph::BEGIN_TUPLE:
+					case hrtds::config::Glyph::END_SCOPE:
+					case hrtds::config::Glyph::IDENTIFIER:
+					case hrtds::config::Glyph::ASSIGNMENT:
+					case hrtds::config::Glyph::QUOTE: {
+						this->Fail(this->input.GetOffset(), "Expected a scalar value.");
+					}
+					default: break;
+				}
+
+				if (!std::isspace(current)) {
+					this->scalar.push_back(static_cast<char>(current));
+				}
+
+				this->input.Skip();
+			}
+
+			if (this->scalar.empty()) {
+				this->Fail(offset, "Expected a value.");
+			}
+		}
+
+		if (type.literal == nullptr) {
+			this->Append(hrtds::config::Glyph::QUOTE);
+			for (const char& character : this->scalar)
+			{
+				this->AppendEscaped(character);
+			}
+			this->Append(hrtds::config::Glyph::QUOTE);
+			return;
+		}
+
+		// Converted by the type's own converter, so the JSON holds the
+		// value HRTDS::Parse(..) would (an int8_ of 300 is 127 in both)
+		void* data = nullptr;
+		try {
+			data = hrtds::data::DynamicConverter::FromText(*type.alias, this->scalar);
+		}
+		catch (const std::exception&) {
+			this->Fail(offset, "The value can not be converted to the type of its identifier.");
+		}
+
+		char scratch[64];
+		std::string_view literal = type.literal(data, scratch);
+		hrtds::data::DynamicConverter::Destroy.at(*type.alias)(data);
+
+		this->Append(literal);
+	}
+
+	void Transcoding::Append(char character)
+	{
+		this->buffer.push_back(character);
+		if (this->buffer.size() >= hrtds::JsonTranscoder::BUFFER_SIZE) {
+			this->Flush();
+		}
+	}
+
+	void Transcoding::Append(size_t count, char character)
+	{
+		this->buffer.append(count, character);
+		if (this->buffer.size() >= hrtds::JsonTranscoder::BUFFER_SIZE) {
+			this->Flush();
+		}
+	}
+
+	void Transcoding::Append(std::string_view string)
+	{
+		this->buffer.append(string);
+		if (this->buffer.size() >= hrtds::JsonTranscoder::BUFFER_SIZE) {
+			this->Flush();
+		}
+	}
+
+	void Transcoding::AppendEscaped(const char& character)
+	{
+		char scratch[6];
+		this->Append(Escape(character, scratch));
+	}
+
+	void Transcoding::AppendKey(std::string_view key)
+	{
+		this->Append(Quote(key));
+		this->Append(hrtds::config::Glyph::ASSIGNMENT);
+		if (this->pretty) this->Append(hrtds::config::Glyph::WHITESPACE_SPACE);
+	}
+
+	void Transcoding::Newline(int level)
+	{
+		if (!this->pretty) {
+			return;
+		}
+
+		this->Append(hrtds::config::Glyph::WHITESPACE_NEWLINE);
+		this->Append(static_cast<size_t>(level), hrtds::config::Glyph::WHITESPACE_TAB);
+	}
+
+	void Transcoding::Flush()
+	{
+		if (this->buffer.empty()) {
+			return;
+		}
+
+		this->sink(this->buffer);
+		this->buffer.clear();
+	}
+
+	void TranscodeInput(Input& input, std::string& buffer, const hrtds::JsonTranscoder::Sink& sink, hrtds::ComposeMode mode, const hrtds::Schema* schema)
+	{
+		Transcoding transcoding(input, buffer, sink, mode);
+		if (schema != nullptr) {
+			transcoding.Adopt(*schema);
+		}
+
+		try {
+			transcoding.Run();
+		}
+		catch (...) {
+			transcoding.Flush();
+			throw;
+		}
+
+		transcoding.Flush();
+	}
+}
+
+hrtds::JsonTranscoder::JsonTranscoder(Sink sink, ComposeMode mode)
+	: sink(std::move(sink)), mode(mode)
+{
+	this->buffer.reserve(JsonTranscoder::BUFFER_SIZE);
+}
+
+hrtds::JsonTranscoder::JsonTranscoder(std::ostream& stream, ComposeMode mode)
+	: JsonTranscoder([&stream](std::string_view text) { stream.write(text.data(), static_cast<std::streamsize>(text.size())); }, mode)
+{}
+
+hrtds::JsonTranscoder::JsonTranscoder(Sink sink, const Schema& schema, ComposeMode mode)
+	: JsonTranscoder(std::move(sink), mode)
+{
+	this->schema = &schema;
+}
+
+hrtds::JsonTranscoder::JsonTranscoder(std::ostream& stream, const Schema& schema, ComposeMode mode)
+	: JsonTranscoder(stream, mode)
+{
+	this->schema = &schema;
+}
+
+void hrtds::JsonTranscoder::Transcode(std::string_view content)
+{
+	Input input(content);
+	TranscodeInput(input, this->buffer, this->sink, this->mode, this->schema);
+}
+
+void hrtds::JsonTranscoder::Transcode(std::istream& stream)
+{
+	Input input(stream);
+	TranscodeInput(input, this->buffer, this->sink, this->mode, this->schema);
+}
+
+std::string hrtds::JsonTranscoder::ToJson(std::string_view content, ComposeMode mode)
+{
+	std::string json;
+	JsonTranscoder transcoder([&json](std::string_view text) { json.append(text); }, mode);
+	transcoder.Transcode(content);
+
+	return json;
+}
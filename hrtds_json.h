@@ -0,0 +1,60 @@
+#pragma once
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string_view>
+
+#include ".\hrtds.h"
+#include ".\hrtds_schema.h"
+
+namespace hrtds {
+	// Turns HRTDS text into JSON in a single pass, without building the
+	// document in between
+	//
+	//	&struct& Vec2 : { &int32_& x, &int32_& y };		{
+	//	&Vec2[]& points : [(1, 2), (3, 4)];		 -->	  "points": [{ "x": 1, "y": 2 }, ...],
+	//	&string& name : "main";							  "name": "main"
+	//													}
+	//
+	// The document becomes an object of its fields (in document order),
+	// tuples become objects keyed by the names in their StructureLayout and
+	// arrays become arrays. Integers, floats, doubles and bools become JSON
+	// numbers and booleans (non-finite decimals become null), strings and
+	// custom types become escaped JSON strings. Struct declarations are
+	// only used to resolve the tuples and are not written.
+	//
+	// Only the struct declarations and the lists currently open are kept.
+	// Input is read (from a stream) and output is handed to the sink in
+	// blocks of BUFFER_SIZE, so the memory used grows with the nesting depth
+	// of the document and not with its size. Malformed input throws
+	// std::runtime_error, naming the byte offset where it went wrong.
+	class JsonTranscoder {
+	public:
+		typedef std::function<void(std::string_view)> Sink;
+
+		JsonTranscoder(Sink sink, ComposeMode mode = ComposeMode::MINIFIED);
+		JsonTranscoder(std::ostream& stream, ComposeMode mode = ComposeMode::MINIFIED);
+
+		// For documents parsed with HRTDS::Parse(.., schema)
+		JsonTranscoder(Sink sink, const Schema& schema, ComposeMode mode = ComposeMode::MINIFIED);
+		JsonTranscoder(std::ostream& stream, const Schema& schema, ComposeMode mode = ComposeMode::MINIFIED);
+
+		JsonTranscoder(const JsonTranscoder& other) = delete;
+
+		JsonTranscoder& operator=(const JsonTranscoder& other) = delete;
+
+		// Writes one JSON object per document. Everything written is handed
+		// to the sink before these return, also when they throw.
+		void Transcode(std::string_view content);
+		void Transcode(std::istream& stream);
+
+		static std::string ToJson(std::string_view content, ComposeMode mode = ComposeMode::MINIFIED);
+
+		static constexpr size_t BUFFER_SIZE = 64 * 1024;
+	private:
+		Sink sink;
+		ComposeMode mode;
+		const Schema* schema = nullptr;
+		std::string buffer;
+	};
+};
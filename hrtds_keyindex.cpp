@@ -0,0 +1,98 @@
+#include "hrtds_keyindex.h"
+
+#include <stdexcept>
+
+hrtds::KeyIndexBase::Matches::Iterator hrtds::KeyIndexBase::Matches::begin() const
+{
+	return Iterator(this->next, this->first);
+}
+
+hrtds::KeyIndexBase::Matches::Iterator hrtds::KeyIndexBase::Matches::end() const
+{
+	return Iterator(this->next, KeyIndexBase::NONE);
+}
+
+size_t hrtds::KeyIndexBase::Matches::size() const
+{
+	return this->count;
+}
+
+bool hrtds::KeyIndexBase::Matches::empty() const
+{
+	return this->count == 0;
+}
+
+hrtds::KeyIndexBase::KeyIndexBase(const Value& array, FieldHandle field, KeyMode mode)
+	: field(std::move(field)), mode(mode)
+{
+	const Identifier& identifier = array.GetIdentifier();
+	if (!identifier.isArray() || identifier.GetIdentifierType() != IdentifierType::TUPLE) {
+		throw std::invalid_argument("Only arrays of tuples can be indexed.");
+	}
+}
+
+const hrtds::FieldHandle& hrtds::KeyIndexBase::GetField() const
+{
+	return this->field;
+}
+
+hrtds::KeyMode hrtds::KeyIndexBase::GetMode() const
+{
+	return this->mode;
+}
+
+size_t hrtds::KeyIndexBase::size() const
+{
+	return this->children != nullptr ? this->next.size() : 0;
+}
+
+bool hrtds::KeyIndexBase::isCurrent(const Value& array) const
+{
+	return this->children != nullptr
+		&& this->children == &array.GetChildren()
+		&& this->next.size() == array.size();
+}
+
+void hrtds::KeyIndexBase::Check(const Value& array) const
+{
+	if (!this->isCurrent(array)) {
+		throw std::logic_error("The index is out of date, Refresh(..) or Rebuild(..) it after changing the array.");
+	}
+}
+
+const std::vector<hrtds::Value>& hrtds::KeyIndexBase::Prepare(const Value& array)
+{
+	const std::vector<Value>& children = array.GetChildren();
+
+	this->children = nullptr;
+	this->next.resize(children.size(), KeyIndexBase::NONE);
+	return children;
+}
+
+void hrtds::KeyIndexBase::Insert(Bucket& bucket, bool inserted, size_t position)
+{
+	if (inserted) {
+		bucket.first = position;
+	}
+	else {
+		this->next[bucket.last] = position;
+	}
+
+	bucket.last = position;
+	bucket.count++;
+}
+
+void hrtds::KeyIndexBase::Reset()
+{
+	this->children = nullptr;
+	this->next.clear();
+}
+
+hrtds::KeyIndexBase::Matches hrtds::KeyIndexBase::MakeMatches(const Bucket* bucket) const
+{
+	if (bucket == nullptr) {
+		return Matches(&this->next, KeyIndexBase::NONE, 0);
+	}
+
+	return Matches(&this->next, bucket->first, bucket->count);
+}
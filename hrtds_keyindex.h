@@ -0,0 +1,257 @@
+#pragma once
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+#include ".\hrtds.h"
+
+namespace hrtds {
+	// How a KeyIndex treats elements which share a key
+	//	* UNIQUE, building the index throws std::invalid_argument
+	//	* MULTIPLE, every element is kept, in the order of the array
+	enum class KeyMode {
+		UNIQUE,
+		MULTIPLE
+	};
+
+	// Everything of a KeyIndex<T> which doesn't depend on the type of the key
+	class KeyIndexBase {
+	public:
+		static constexpr size_t NONE = static_cast<size_t>(-1);
+
+		// The positions of every element sharing a key, in array order
+		//
+		//	   keys:	 "a"	"b"	   "a"	  "c"	 "b"	"a"
+		//	   next:	 [ 2,	 4,		5,	   NONE,  NONE,	 NONE ]
+		//	   "a":		   0 ---------> 2 ----------------> 5
+		class Matches {
+		public:
+			class Iterator {
+			public:
+				size_t operator*() const { return this->position; }
+				Iterator& operator++() { this->position = (*this->next)[this->position]; return *this; }
+				bool operator==(const Iterator& other) const { return this->position == other.position; }
+				bool operator!=(const Iterator& other) const { return this->position != other.position; }
+			private:
+				friend class Matches;
+				Iterator(const std::vector<size_t>* next, size_t position) : next(next), position(position) {}
+
+				const std::vector<size_t>* next;
+				size_t position;
+			};
+
+			Iterator begin() const;
+			Iterator end() const;
+			size_t size() const;
+			bool empty() const;
+		private:
+			friend class KeyIndexBase;
+			Matches(const std::vector<size_t>* next, size_t first, size_t count) : next(next), first(first), count(count) {}
+
+			const std::vector<size_t>* next;
+			size_t first;
+			size_t count;
+		};
+
+		const FieldHandle& GetField() const;
+		KeyMode GetMode() const;
+
+		// How many elements are indexed
+		size_t size() const;
+
+		// Whether 'array' is the array the index was built over, with no
+		// element added or removed since. Key fields edited in place are not
+		// noticed, Rebuild(..) the index after editing one.
+		bool isCurrent(const Value& array) const;
+	protected:
+		// The elements sharing a key, 'first' and 'last' are positions
+		struct Bucket {
+			size_t first = NONE;
+			size_t last = NONE;
+			size_t count = 0;
+		};
+
+		// 'array' has to be an array of tuples, and 'field' has to belong
+		// to their struct
+		KeyIndexBase(const Value& array, FieldHandle field, KeyMode mode);
+
+		// Throws std::logic_error unless isCurrent(array)
+		void Check(const Value& array) const;
+
+		// Makes room for every element of 'array', of which the ones not
+		// indexed yet are about to be inserted. The index is out of date
+		// until they are.
+		const std::vector<Value>& Prepare(const Value& array);
+		void Insert(Bucket& bucket, bool inserted, size_t position);
+		void Reset();
+
+		Matches MakeMatches(const Bucket* bucket) const;
+
+		FieldHandle field;
+		KeyMode mode;
+
+		// The children of the array indexed, nullptr while invalidated
+		const std::vector<Value>* children = nullptr;
+		std::vector<size_t> next;
+	};
+
+	// A hash index over an array of tuples, keyed by one scalar field of
+	// their struct
+	//
+	//	hrtds::KeyIndex<std::string> byId(document, document["elements"], "id", hrtds::KeyMode::UNIQUE);
+	//	const hrtds::Value* element = byId.Find(document["elements"], "main");
+	//
+	// Lookups are O(1) rather than a scan over GetChildren(). The index
+	// keeps positions into the array, and only reads the array while it is
+	// built: after appending to the array Refresh(..) indexes the new
+	// elements, after any other change Rebuild(..) it (or Invalidate() it).
+	// Every lookup throws while the index is out of date. String keys are
+	// copied into the index, and looked up by std::string_view.
+	template<typename T>
+	class KeyIndex : public KeyIndexBase {
+	public:
+		typedef std::conditional_t<std::is_same_v<T, std::string>, std::string_view, T> Key;
+
+		// 'field' has to be a field of type T (see TypedFieldHandle<T>)
+		KeyIndex(const HRTDS& hrtds, const Value& array, const std::string& field, KeyMode mode = KeyMode::MULTIPLE);
+
+		void Rebuild(const Value& array);
+
+		// Indexes the elements appended to 'array' since, or rebuilds the
+		// index if the array changed otherwise
+		void Refresh(const Value& array);
+
+		// Drops every entry until the next Rebuild(..) or Refresh(..)
+		void Invalidate();
+
+		// The position of the (first) element of 'array' with 'key', NONE
+		// if there is none
+		size_t IndexOf(const Value& array, const Key& key) const;
+		size_t Count(const Value& array, const Key& key) const;
+		Matches FindAll(const Value& array, const Key& key) const;
+
+		// The (first) element of 'array' with 'key', nullptr if there is none
+		const Value* Find(const Value& array, const Key& key) const;
+	private:
+		// Hashes std::string keys as the views they are looked up by
+		struct KeyHash {
+			using is_transparent = void;
+			size_t operator()(const Key& key) const { return std::hash<Key>()(key); }
+		};
+
+		void Index(const Value& array, size_t from);
+
+		std::unordered_map<T, Bucket, KeyHash, std::equal_to<>> buckets;
+	};
+
+	template<typename T>
+	inline KeyIndex<T>::KeyIndex(const HRTDS& hrtds, const Value& array, const std::string& field, KeyMode mode)
+		: KeyIndexBase(array, TypedFieldHandle<T>(hrtds, array.GetIdentifier().GetIdentifierName(), field), mode)
+	{
+		this->Rebuild(array);
+	}
+
+	template<typename T>
+	inline void KeyIndex<T>::Rebuild(const Value& array)
+	{
+		this->Invalidate();
+		this->buckets.reserve(array.size());
+		this->Index(array, 0);
+	}
+
+	template<typename T>
+	inline void KeyIndex<T>::Refresh(const Value& array)
+	{
+		if (this->children != &array.GetChildren() || array.size() < this->next.size()) {
+			this->Rebuild(array);
+			return;
+		}
+
+		this->Index(array, this->next.size());
+	}
+
+	template<typename T>
+	inline void KeyIndex<T>::Invalidate()
+	{
+		this->buckets.clear();
+		this->Reset();
+	}
+
+	template<typename T>
+	inline size_t KeyIndex<T>::IndexOf(const Value& array, const Key& key) const
+	{
+		this->Check(array);
+
+		auto it = this->buckets.find(key);
+		return it != this->buckets.end() ? it->second.first : KeyIndexBase::NONE;
+	}
+
+	template<typename T>
+	inline size_t KeyIndex<T>::Count(const Value& array, const Key& key) const
+	{
+		this->Check(array);
+
+		auto it = this->buckets.find(key);
+		return it != this->buckets.end() ? it->second.count : 0;
+	}
+
+	template<typename T>
+	inline KeyIndexBase::Matches KeyIndex<T>::FindAll(const Value& array, const Key& key) const
+	{
+		this->Check(array);
+
+		auto it = this->buckets.find(key);
+		return this->MakeMatches(it != this->buckets.end() ? &it->second : nullptr);
+	}
+
+	template<typename T>
+	inline const Value* KeyIndex<T>::Find(const Value& array, const Key& key) const
+	{
+		size_t position = this->IndexOf(array, key);
+		return position != KeyIndexBase::NONE ? &array.GetChildren()[position] : nullptr;
+	}
+
+	template<typename T>
+	inline void KeyIndex<T>::Index(const Value& array, size_t from)
+	{
+		const std::vector<Value>& children = this->Prepare(array);
+		try {
+			for (size_t position = from; position < children.size(); position++)
+			{
+				const Value& key = children[position][this->field];
+
+				Key value;
+				if constexpr (std::is_same_v<T, std::string>) {
+					value = key.GetString();
+				}
+				else {
+					const T* data = key.template Get<T>();
+					if (data == nullptr) {
+						throw std::runtime_error("The key field of element " + std::to_string(position) + " holds no value.");
+					}
+
+					value = *data;
+				}
+
+				// Looked up first, so a key which is there already isn't copied
+				auto it = this->buckets.find(value);
+				bool inserted = it == this->buckets.end();
+				if (inserted) {
+					it = this->buckets.emplace(T(value), Bucket()).first;
+				}
+				else if (this->mode == KeyMode::UNIQUE) {
+					throw std::invalid_argument("The elements " + std::to_string(it->second.first) + " and " + std::to_string(position) + " share a key, which a unique index does not allow.");
+				}
+
+				this->Insert(it->second, inserted, position);
+			}
+		}
+		catch (...) {
+			this->Invalidate();
+			throw;
+		}
+
+		this->children = &children;
+	}
+};
@@ -0,0 +1,557 @@
+#include "hrtds_offsets.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include ".\hrtds_composer.h"
+#include ".\hrtds_config.h"
+
+namespace {
+	constexpr char INDEX_MAGIC[8] = { 'H', 'R', 'T', 'D', 'S', 'I', 'D', 'X' };
+	// 2: the content hash is data::HashBytes(..)
+	constexpr uint64_t INDEX_VERSION = 2;
+
+	constexpr size_t HASH_BLOCK_SIZE = 64 * 1024;
+
+	// Same as OffsetIndex::Hash(..) over the whole stream, block by block
+	uint64_t HashStream(std::istream& stream)
+	{
+		stream.clear();
+		stream.seekg(0);
+
+		uint64_t hash = hrtds::data::HASH_SEED;
+		std::string block(HASH_BLOCK_SIZE, '\0');
+		while (stream)
+		{
+			stream.read(block.data(), static_cast<std::streamsize>(block.size()));
+			hash = hrtds::data::HashBytes(block.data(), static_cast<size_t>(stream.gcount()), hash);
+		}
+
+		return hash;
+	}
+
+	bool isWhitespace(char character)
+	{
+		return std::isspace(static_cast<unsigned char>(character));
+	}
+
+	std::string_view Trim(std::string_view text)
+	{
+		while (!text.empty() && isWhitespace(text.front())) text.remove_prefix(1);
+		while (!text.empty() && isWhitespace(text.back())) text.remove_suffix(1);
+		return text;
+	}
+
+	std::string ReadRange(std::istream& stream, const hrtds::OffsetIndex::Range& range)
+	{
+		std::string text(range.end - range.begin, '\0');
+
+		stream.clear();
+		stream.seekg(static_cast<std::streamoff>(range.begin));
+		stream.read(text.data(), static_cast<std::streamsize>(text.size()));
+		if (static_cast<size_t>(stream.gcount()) != text.size()) {
+			throw std::runtime_error("The file is shorter than its index. (Could not read the bytes the index points at)");
+		}
+
+		return text;
+	}
+
+	// The text of the element 'skip' elements after the one 'block'
+	// begins with, 'block' ends at or after the end of that element
+	std::string_view ElementText(std::string_view block, size_t skip)
+	{
+		size_t begin = 0;
+		int depth = 0;
+		bool inString = false;
+		for (size_t i = 0; i < block.size(); i++)
+		{
+			char current = block[i];
+			if (current == hrtds::config::Glyph::QUOTE) {
+				inString = !inString;
+				continue;
+			}
+
+			if (inString) {
+				continue;
+			}
+
+			if (current == hrtds::config::Glyph::BEGIN_ARRAY || current == hrtds::config::Glyph::BEGIN_TUPLE || current == hrtds::config::Glyph::BEGIN_SCOPE) {
+				depth++;
+			}
+			else if (current == hrtds::config::Glyph::END_ARRAY || current == hrtds::config::Glyph::END_TUPLE || current == hrtds::config::Glyph::END_SCOPE) {
+				// The end of the array itself
+				if (--depth < 0) {
+					return Trim(block.substr(begin, i - begin));
+				}
+			}
+			else if (current == hrtds::config::Glyph::LIST_SEPARATOR && depth == 0) {
+				if (skip == 0) {
+					return Trim(block.substr(begin, i - begin));
+				}
+
+				skip--;
+				begin = i + 1;
+			}
+		}
+
+		return Trim(block.substr(begin));
+	}
+
+	// A step of a path after the field, "[index]" or ".name"
+	struct PathStep {
+		bool isIndex = false;
+		size_t index = 0;
+		std::string name;
+	};
+
+	void WriteInteger(std::ostream& stream, uint64_t value)
+	{
+		stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+	void WriteString(std::ostream& stream, const std::string& string)
+	{
+		WriteInteger(stream, string.size());
+		stream.write(string.data(), static_cast<std::streamsize>(string.size()));
+	}
+
+	// Reads the saved index, every Read(..) fails instead of reading past
+	// the end, so a truncated or foreign file is simply not loaded
+	struct IndexReader {
+		std::string_view data;
+		size_t cursor = 0;
+
+		bool Read(uint64_t& value)
+		{
+			if (this->data.size() - this->cursor < sizeof(value)) return false;
+			std::memcpy(&value, this->data.data() + this->cursor, sizeof(value));
+			this->cursor += sizeof(value);
+			return true;
+		}
+
+		bool Read(std::string& string)
+		{
+			uint64_t length = 0;
+			if (!this->Read(length) || this->data.size() - this->cursor < length) return false;
+			string.assign(this->data.substr(this->cursor, length));
+			this->cursor += length;
+			return true;
+		}
+
+		// A count of 'size' byte entries, which can't be more than what is left
+		bool ReadCount(uint64_t& count, size_t size)
+		{
+			return this->Read(count) && count <= (this->data.size() - this->cursor) / size;
+		}
+	};
+}
+
+hrtds::OffsetIndex hrtds::OffsetIndex::Build(std::string_view content, size_t stride)
+{
+	const std::string& beginMarker = config::GlyphLiterals::BEGIN_FILE_SCOPE;
+	const std::string& endMarker = config::GlyphLiterals::END_FILE_SCOPE;
+
+	OffsetIndex index;
+	index.size = content.size();
+	index.hash = OffsetIndex::Hash(content);
+	index.stride = std::max<size_t>(stride, 1);
+
+	size_t begin = content.find(beginMarker);
+	if (begin == content.npos) {
+		throw std::runtime_error("The file needs to include a '" + beginMarker + "' to mark the beginning of the file. (The file-begin-marker could not be found)");
+	}
+
+	// One statement at a time, each ending at a ';' outside of a string
+	// and of any brackets
+	size_t cursor = begin + beginMarker.size();
+	while (true)
+	{
+		while (cursor < content.size() && isWhitespace(content[cursor])) cursor++;
+		if (cursor >= content.size()) {
+			throw std::runtime_error("The file needs to include a '" + endMarker + "' to mark the end of the file. (The file-end-marker could not be found)");
+		}
+
+		if (content.compare(cursor, endMarker.size(), endMarker) == 0) {
+			break;
+		}
+
+		//	&int32_[]& Version : [1, 0, 0];
+		//	^		 ^		   ^
+		size_t statementBegin = cursor;
+		size_t identifierEnd = content[cursor] == config::Glyph::IDENTIFIER ? content.find(config::Glyph::IDENTIFIER, cursor + 1) : content.npos;
+		size_t assignment = identifierEnd != content.npos ? content.find(config::Glyph::ASSIGNMENT, identifierEnd + 1) : content.npos;
+		if (assignment == content.npos) {
+			throw std::runtime_error("Expected an identifier, a name and a value at byte " + std::to_string(statementBegin) + ". (Could not find the statement's '&..&' and ':')");
+		}
+
+		std::string_view identifier = Trim(content.substr(cursor + 1, identifierEnd - cursor - 1));
+		std::string_view name = Trim(content.substr(identifierEnd + 1, assignment - identifierEnd - 1));
+
+		size_t valueBegin = assignment + 1;
+		while (valueBegin < content.size() && isWhitespace(content[valueBegin])) valueBegin++;
+
+		FieldOffsets field;
+		bool isArray = identifier.ends_with("[]") && valueBegin < content.size() && content[valueBegin] == config::Glyph::BEGIN_ARRAY;
+
+		// Where every element of an array begins is the first character
+		// which isn't whitespace after the '[' or a ',' of the array
+		int depth = 0;
+		bool inString = false;
+		bool elementPending = false;
+		size_t terminator = content.npos;
+		for (size_t i = valueBegin; i < content.size() && terminator == content.npos; i++)
+		{
+			char current = content[i];
+			if (elementPending && !isWhitespace(current)) {
+				elementPending = false;
+				if (depth != 1 || current != config::Glyph::END_ARRAY) {
+					if (field.count % index.stride == 0) field.elements.push_back(i);
+					field.count++;
+				}
+			}
+
+			if (current == config::Glyph::QUOTE) {
+				inString = !inString;
+			}
+			else if (inString) {
+				continue;
+			}
+			else if (current == config::Glyph::BEGIN_ARRAY || current == config::Glyph::BEGIN_TUPLE || current == config::Glyph::BEGIN_SCOPE) {
+				depth++;
+				elementPending |= isArray && i == valueBegin;
+			}
+			else if (current == config::Glyph::END_ARRAY || current == config::Glyph::END_TUPLE || current == config::Glyph::END_SCOPE) {
+				depth--;
+			}
+			else if (current == config::Glyph::LIST_SEPARATOR) {
+				elementPending |= isArray && depth == 1;
+			}
+			else if (current == config::Glyph::TERMINATOR && depth == 0) {
+				terminator = i;
+			}
+		}
+
+		if (terminator == content.npos) {
+			throw std::runtime_error("Expected a '" + std::string(1, config::Glyph::TERMINATOR) + "' to end the statement at byte " + std::to_string(statementBegin) + ". (Could not find the end of the statement)");
+		}
+
+		cursor = terminator + 1;
+		if (identifier == config::IdenifierLiterals::STRUCT_IDENTIFIER) {
+			index.structs.push_back({ statementBegin, cursor });
+			continue;
+		}
+
+		std::string_view value = Trim(content.substr(valueBegin, terminator - valueBegin));
+		field.name = std::string(name);
+		field.identifier = std::string(identifier);
+		field.value = { valueBegin, valueBegin + value.size() };
+
+		index.fieldMap[field.name] = index.fields.size();
+		index.fields.push_back(std::move(field));
+	}
+
+	return index;
+}
+
+void hrtds::OffsetIndex::Save(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		throw std::runtime_error("Could not open '" + path + "' for writing.");
+	}
+
+	file.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	WriteInteger(file, INDEX_VERSION);
+	WriteInteger(file, this->size);
+	WriteInteger(file, this->hash);
+	WriteInteger(file, this->stride);
+
+	WriteInteger(file, this->structs.size());
+	for (const Range& structure : this->structs)
+	{
+		WriteInteger(file, structure.begin);
+		WriteInteger(file, structure.end);
+	}
+
+	WriteInteger(file, this->fields.size());
+	for (const FieldOffsets& field : this->fields)
+	{
+		WriteString(file, field.name);
+		WriteString(file, field.identifier);
+		WriteInteger(file, field.value.begin);
+		WriteInteger(file, field.value.end);
+		WriteInteger(file, field.count);
+
+		WriteInteger(file, field.elements.size());
+		for (uint64_t element : field.elements)
+		{
+			WriteInteger(file, element);
+		}
+	}
+
+	if (!file) {
+		throw std::runtime_error("Could not write to '" + path + "'.");
+	}
+}
+
+bool hrtds::OffsetIndex::Load(const std::string& path, OffsetIndex& index)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (data.size() < sizeof(INDEX_MAGIC) || data.compare(0, sizeof(INDEX_MAGIC), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+		return false;
+	}
+
+	IndexReader reader = { data, sizeof(INDEX_MAGIC) };
+	OffsetIndex loaded;
+
+	uint64_t version = 0;
+	if (!reader.Read(version) || version != INDEX_VERSION) return false;
+	if (!reader.Read(loaded.size) || !reader.Read(loaded.hash) || !reader.Read(loaded.stride) || loaded.stride == 0) return false;
+
+	uint64_t structCount = 0;
+	if (!reader.ReadCount(structCount, 2 * sizeof(uint64_t))) return false;
+	loaded.structs.resize(structCount);
+	for (Range& structure : loaded.structs)
+	{
+		if (!reader.Read(structure.begin) || !reader.Read(structure.end)) return false;
+	}
+
+	uint64_t fieldCount = 0;
+	if (!reader.ReadCount(fieldCount, 6 * sizeof(uint64_t))) return false;
+	loaded.fields.resize(fieldCount);
+	for (FieldOffsets& field : loaded.fields)
+	{
+		uint64_t elementCount = 0;
+		if (!reader.Read(field.name) || !reader.Read(field.identifier)) return false;
+		if (!reader.Read(field.value.begin) || !reader.Read(field.value.end) || !reader.Read(field.count)) return false;
+		if (!reader.ReadCount(elementCount, sizeof(uint64_t))) return false;
+
+		field.elements.resize(elementCount);
+		for (uint64_t& element : field.elements)
+		{
+			if (!reader.Read(element)) return false;
+		}
+
+		loaded.fieldMap[field.name] = &field - loaded.fields.data();
+	}
+
+	index = std::move(loaded);
+	return true;
+}
+
+bool hrtds::OffsetIndex::Matches(std::string_view content) const
+{
+	return content.size() == this->size && OffsetIndex::Hash(content) == this->hash;
+}
+
+const std::vector<hrtds::OffsetIndex::Range>& hrtds::OffsetIndex::GetStructs() const
+{
+	return this->structs;
+}
+
+const std::vector<hrtds::OffsetIndex::FieldOffsets>& hrtds::OffsetIndex::GetFields() const
+{
+	return this->fields;
+}
+
+const hrtds::OffsetIndex::FieldOffsets* hrtds::OffsetIndex::Find(const std::string& name) const
+{
+	auto it = this->fieldMap.find(name);
+	return it != this->fieldMap.end() ? &this->fields[it->second] : nullptr;
+}
+
+size_t hrtds::OffsetIndex::GetStride() const
+{
+	return this->stride;
+}
+
+uint64_t hrtds::OffsetIndex::GetSize() const
+{
+	return this->size;
+}
+
+uint64_t hrtds::OffsetIndex::GetHash() const
+{
+	return this->hash;
+}
+
+uint64_t hrtds::OffsetIndex::Hash(std::string_view content)
+{
+	return data::HashBytes(content.data(), content.size());
+}
+
+std::string hrtds::OffsetIndex::SidecarPath(const std::string& path)
+{
+	return path + ".idx";
+}
+
+void hrtds::OffsetIndex::ComposeFile(const HRTDS& hrtds, const std::string& path, ComposeMode mode, size_t stride)
+{
+	std::string composed = Composer(mode).Compose(hrtds);
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		throw std::runtime_error("Could not open '" + path + "' for writing.");
+	}
+
+	file.write(composed.data(), static_cast<std::streamsize>(composed.size()));
+	if (!file) {
+		throw std::runtime_error("Could not write to '" + path + "'.");
+	}
+
+	OffsetIndex::Build(composed, stride).Save(OffsetIndex::SidecarPath(path));
+}
+
+hrtds::Value hrtds::OffsetIndex::ParseFile(const std::string& file, std::string_view path)
+{
+	return OffsetFile(file).Parse(path);
+}
+
+hrtds::OffsetFile::OffsetFile(const std::string& file)
+	: stream(file, std::ios::binary)
+{
+	if (!this->stream) {
+		throw std::runtime_error("Could not open '" + file + "' for reading.");
+	}
+
+	this->stream.seekg(0, std::ios::end);
+	uint64_t fileSize = static_cast<uint64_t>(this->stream.tellg());
+
+	std::string sidecar = OffsetIndex::SidecarPath(file);
+	bool current = OffsetIndex::Load(sidecar, this->index) && this->index.GetSize() == fileSize && this->index.GetHash() == HashStream(this->stream);
+	if (!current) {
+		std::string content = ReadRange(this->stream, { 0, fileSize });
+		this->index = OffsetIndex::Build(content);
+
+		// The index only saves time, a file next to which nothing can be
+		// written (a read-only directory) is still parsed
+		try {
+			this->index.Save(sidecar);
+		}
+		catch (const std::runtime_error&) {}
+	}
+
+	// Every value is parsed as a document of its own, following the structs
+	this->structs = config::GlyphLiterals::BEGIN_FILE_SCOPE;
+	for (const OffsetIndex::Range& structure : this->index.GetStructs())
+	{
+		this->structs += ReadRange(this->stream, structure);
+	}
+}
+
+const hrtds::OffsetIndex& hrtds::OffsetFile::GetIndex() const
+{
+	return this->index;
+}
+
+hrtds::Value hrtds::OffsetFile::Parse(std::string_view path)
+{
+	// "Windows[12].Title" --> "Windows", [12], .Title
+	size_t nameEnd = std::min(path.find(config::Glyph::BEGIN_ARRAY), path.find('.'));
+	std::string name = std::string(path.substr(0, nameEnd));
+	if (name.empty()) {
+		throw std::invalid_argument("The path '" + std::string(path) + "' needs to begin with the name of a field.");
+	}
+
+	std::vector<PathStep> steps;
+	for (size_t i = name.size(); i < path.size();)
+	{
+		PathStep step;
+		if (path[i] == config::Glyph::BEGIN_ARRAY) {
+			size_t end = path.find(config::Glyph::END_ARRAY, i);
+			std::string_view digits = end != path.npos ? path.substr(i + 1, end - i - 1) : std::string_view();
+			if (digits.empty() || !std::all_of(digits.begin(), digits.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); })) {
+				throw std::invalid_argument("The path '" + std::string(path) + "' has an invalid index. (Expected '[' digits ']')");
+			}
+
+			step.isIndex = true;
+			step.index = std::stoull(std::string(digits));
+			i = end + 1;
+		}
+		else if (path[i] == '.') {
+			size_t end = std::min(path.find(config::Glyph::BEGIN_ARRAY, i + 1), path.find('.', i + 1));
+			step.name = std::string(path.substr(i + 1, end == path.npos ? path.npos : end - i - 1));
+			if (step.name.empty()) {
+				throw std::invalid_argument("The path '" + std::string(path) + "' has an empty name after a '.'.");
+			}
+
+			i = end == path.npos ? path.size() : end;
+		}
+		else {
+			throw std::invalid_argument("The path '" + std::string(path) + "' has an unexpected '" + std::string(1, path[i]) + "'.");
+		}
+
+		steps.push_back(std::move(step));
+	}
+
+	const OffsetIndex::FieldOffsets* field = this->index.Find(name);
+	if (field == nullptr) {
+		throw std::out_of_range("The document has no field named '" + name + "'.");
+	}
+
+	// An element of a top-level array is read on its own, starting from
+	// the closest element the index recorded
+	std::string identifier = field->identifier;
+	std::string text;
+	size_t step = 0;
+	if (!steps.empty() && steps[0].isIndex && identifier.ends_with("[]")) {
+		size_t element = steps[0].index;
+		if (element >= field->count) {
+			throw std::out_of_range("The element " + std::to_string(element) + " is out of range for the field '" + name + "'.");
+		}
+
+		size_t stride = this->index.GetStride();
+		size_t recorded = element / stride;
+		OffsetIndex::Range block = { field->elements[recorded], recorded + 1 < field->elements.size() ? field->elements[recorded + 1] : field->value.end };
+		text = std::string(ElementText(ReadRange(this->stream, block), element % stride));
+
+		identifier.resize(identifier.size() - 2);
+		step = 1;
+	}
+	else {
+		text = ReadRange(this->stream, field->value);
+	}
+
+	// The structs, followed by the value as a field of its own
+	std::string content = this->structs;
+	content += config::Glyph::IDENTIFIER;
+	content += identifier;
+	content += config::Glyph::IDENTIFIER;
+	content += config::Glyph::WHITESPACE_SPACE;
+	content += name;
+	content += config::Glyph::ASSIGNMENT;
+	content += text;
+	content += config::Glyph::TERMINATOR;
+	content += config::GlyphLiterals::END_FILE_SCOPE;
+
+	HRTDS document;
+	HRTDS::Parse(document, std::move(content));
+
+	Value value = std::move(document[name]);
+	for (; step < steps.size(); step++)
+	{
+		Value child;
+		if (steps[step].isIndex) {
+			if (steps[step].index >= value.size()) {
+				throw std::out_of_range("The element " + std::to_string(steps[step].index) + " is out of range. (In the path '" + std::string(path) + "')");
+			}
+
+			child = std::move(value[steps[step].index]);
+		}
+		else {
+			child = std::move(value[steps[step].name]);
+		}
+
+		value = std::move(child);
+	}
+
+	return value;
+}
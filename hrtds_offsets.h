@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string_view>
+#include <unordered_map>
+
+#include ".\hrtds.h"
+
+namespace hrtds {
+	// Byte offsets into the text of a document, kept in a sidecar file
+	// next to it ("<file>.idx") so a single value can be parsed without
+	// parsing everything before it
+	//
+	//	${
+	//		&struct& Vec2 : { ... };		<-- every struct, [begin, end)
+	//		&Vec2[]& Points : [			<-- every field's value, [begin, end)
+	//			(0, 0),					<-- element 0
+	//			...
+	//			(7, 3),					<-- element 'stride'
+	//			...
+	//
+	// Only every 'stride'th element of an array is recorded, the ones in
+	// between are found by scanning forward from the closest recorded one.
+	// The index remembers the size and hash of the content it was built
+	// from, an index which doesn't match its file any more is stale.
+	class OffsetIndex {
+	public:
+		struct Range {
+			uint64_t begin = 0;
+			uint64_t end = 0;
+		};
+
+		struct FieldOffsets {
+			std::string name;
+
+			// As written in the document, like "Vec2[]"
+			std::string identifier;
+			Range value;
+
+			// Arrays only, the element count and where element i * stride begins
+			uint64_t count = 0;
+			std::vector<uint64_t> elements;
+		};
+
+		OffsetIndex() = default;
+
+		// Scans 'content' once, without parsing any value
+		static OffsetIndex Build(std::string_view content, size_t stride = OffsetIndex::DEFAULT_STRIDE);
+
+		// Throws if the file can not be written
+		void Save(const std::string& path) const;
+
+		// False if there is no (readable) index at 'path'
+		static bool Load(const std::string& path, OffsetIndex& index);
+
+		// Whether the index was built from exactly this content
+		bool Matches(std::string_view content) const;
+
+		const std::vector<Range>& GetStructs() const;
+		const std::vector<FieldOffsets>& GetFields() const;
+
+		// nullptr if the document has no field named 'name'
+		const FieldOffsets* Find(const std::string& name) const;
+
+		size_t GetStride() const;
+		uint64_t GetSize() const;
+		uint64_t GetHash() const;
+
+		static uint64_t Hash(std::string_view content);
+		static std::string SidecarPath(const std::string& path);
+
+		// Composes 'hrtds' into the file at 'path', and its index next to it
+		static void ComposeFile(const HRTDS& hrtds, const std::string& path, ComposeMode mode = ComposeMode::PRETTY, size_t stride = OffsetIndex::DEFAULT_STRIDE);
+
+		// Parses only the value at 'path' of the document in 'file', like
+		// "Windows[12].Title" (a field, followed by any number of [index]
+		// and .name). Opens an OffsetFile for the one value, which checks
+		// the index against the whole file, keep an OffsetFile open to
+		// parse more than one.
+		static Value ParseFile(const std::string& file, std::string_view path);
+
+		static constexpr size_t DEFAULT_STRIDE = 1024;
+	private:
+		uint64_t size = 0;
+		uint64_t hash = 0;
+		uint64_t stride = OffsetIndex::DEFAULT_STRIDE;
+
+		std::vector<Range> structs;
+		std::vector<FieldOffsets> fields;
+		std::unordered_map<std::string, size_t> fieldMap;
+	};
+
+	// A document file opened together with its index. The index next to
+	// the file is used if it matches the file, otherwise it is built (and
+	// saved) first, which reads the file once, when opening it. Every
+	// Parse(..) after that only reads the bytes of the requested value.
+	//
+	//	hrtds::OffsetFile world("world.hrtds");
+	//	hrtds::Value first = world.Parse("Entities[12].Name");
+	//	hrtds::Value second = world.Parse("Entities[654321].Name");
+	//
+	// The file is kept open, and has to stay as it was when it was opened.
+	class OffsetFile {
+	public:
+		explicit OffsetFile(const std::string& file);
+		OffsetFile(const OffsetFile& other) = delete;
+
+		OffsetFile& operator=(const OffsetFile& other) = delete;
+
+		// See OffsetIndex::ParseFile(..) for 'path'
+		Value Parse(std::string_view path);
+
+		const OffsetIndex& GetIndex() const;
+	private:
+		std::ifstream stream;
+		OffsetIndex index;
+
+		// The file-begin-marker followed by every struct, which every
+		// parsed value is prefixed with
+		std::string structs;
+	};
+};
@@ -0,0 +1,511 @@
+#include "hrtds_projection.h"
+
+#include <cctype>
+#include <stdexcept>
+
+#include ".\hrtds_config.h"
+#include ".\hrtds_trace.h"
+
+namespace {
+	bool isWhitespace(char character)
+	{
+		return std::isspace(static_cast<unsigned char>(character));
+	}
+
+	// Where the value beginning at 'cursor' ends, at the ',', ')', ']' or
+	// ';' following it. Strings and nested lists are stepped over whole.
+	size_t SkipValue(std::string_view content, size_t cursor)
+	{
+		int depth = 0;
+		for (; cursor < content.size(); cursor++)
+		{
+			switch (content[cursor])
+			{
+				case hrtds::config::Glyph::QUOTE: {
+					cursor = content.find(hrtds::config::Glyph::QUOTE, cursor + 1);
+					if (cursor == content.npos) {
+						throw std::runtime_error("To define a string you need both an opening quotationmark and a closing one. (Could not find closing quotationmark)");
+					}
+					break;
+				}
+				case hrtds::config::Glyph::BEGIN_ARRAY:
+				case hrtds::config::Glyph::BEGIN_TUPLE:
+				case hrtds::config::Glyph::BEGIN_SCOPE: {
+					depth++;
+					break;
+				}
+				case hrtds::config::Glyph::END_ARRAY:
+				case hrtds::config::Glyph::END_TUPLE:
+				case hrtds::config::Glyph::END_SCOPE: {
+					if (depth == 0) return cursor;
+					depth--;
+					break;
+				}
+				case hrtds::config::Glyph::LIST_SEPARATOR:
+				case hrtds::config::Glyph::TERMINATOR: {
+					if (depth == 0) return cursor;
+					break;
+				}
+				default: break;
+			}
+		}
+
+		return cursor;
+	}
+
+	// Reads up to (not including) 'stop', returning the text with its
+	// whitespace removed
+	std::string ReadUntil(std::string_view content, size_t& cursor, char stop, const char* message)
+	{
+		size_t end = content.find(stop, cursor);
+		if (end == content.npos) {
+			throw std::runtime_error(message);
+		}
+
+		std::string text;
+		for (; cursor < end; cursor++)
+		{
+			if (!isWhitespace(content[cursor])) {
+				text.push_back(content[cursor]);
+			}
+		}
+
+		cursor++;
+		return text;
+	}
+
+	// A top-level field which is only partly selected
+	struct PendingField {
+		std::string identifier;
+		std::string name;
+		size_t node;
+		size_t begin;
+	};
+
+	// Builds the selected parts of a value straight from its text, the
+	// rest is skipped with SkipValue(..)
+	class ProjectedParser {
+	public:
+		ProjectedParser(std::string_view content, const hrtds::Projection& projection, const hrtds::HRTDS& document)
+			: content(content), nodes(projection.GetNodes()), document(document), elementNodes(projection.GetNodes().size())
+		{
+			hrtds::InternPool* pool = this->document.GetInternPool().get();
+			this->pool = pool != nullptr && pool->hasInternedFields() ? pool : nullptr;
+		}
+
+		hrtds::Value Parse(const hrtds::Identifier& identifier, size_t node, const std::string& name, size_t begin)
+		{
+			this->cursor = begin;
+			bool intern = this->pool != nullptr && this->pool->isInternedField(name);
+			return this->Field(identifier, node, name, intern);
+		}
+	private:
+		hrtds::Value Field(const hrtds::Identifier& identifier, size_t node, const std::string& name, bool intern);
+		hrtds::Value Element(const hrtds::Identifier& identifier, size_t node, const std::string& name, bool intern);
+		hrtds::Value Scalar(const hrtds::Identifier& identifier, bool intern);
+
+		char Peek();
+		void Expect(char glyph, const char* message);
+
+		// The node of every field of the struct, ROOT for fields which
+		// aren't selected. Resolved on the first tuple of 'node'.
+		const std::vector<size_t>& ElementNodes(size_t node, const hrtds::TupleLayout& layout, const std::string& name);
+		const std::shared_ptr<const hrtds::TupleLayout>& GetLayout(const std::string& structure);
+
+		std::string_view content;
+		size_t cursor = 0;
+
+		const std::vector<hrtds::Projection::Node>& nodes;
+		const hrtds::HRTDS& document;
+		hrtds::InternPool* pool = nullptr;
+
+		std::vector<std::vector<size_t>> elementNodes;
+		std::unordered_map<std::string, std::shared_ptr<const hrtds::TupleLayout>> layouts;
+
+		// Reused by every unquoted scalar
+		std::string text;
+	};
+
+	hrtds::Value ProjectedParser::Field(const hrtds::Identifier& identifier, size_t node, const std::string& name, bool intern)
+	{
+		if (!identifier.isArray()) {
+			return this->Element(identifier, node, name, intern);
+		}
+
+		const hrtds::Projection::Node& step = this->nodes[node];
+		size_t elementNode = step.whole ? node : step.element;
+		if (elementNode == hrtds::Projection::ROOT) {
+			throw std::invalid_argument("'" + name + "' is an array, select its elements with '[*]'.");
+		}
+
+		hrtds::Value array = hrtds::Value();
+		array.SetIdentifier(identifier);
+
+		// Every element is of our type, minus the array
+		hrtds::Identifier childIdentifier = identifier;
+		childIdentifier.SetArray(false);
+
+		std::vector<hrtds::Value> children;
+		this->Expect(hrtds::config::Glyph::BEGIN_ARRAY, "Expected a '[' to begin the array.");
+		if (this->Peek() == hrtds::config::Glyph::END_ARRAY) {
+			this->cursor++;
+			array.SetChildren(std::move(children));
+			return array;
+		}
+
+		while (true)
+		{
+			children.emplace_back(this->Element(childIdentifier, elementNode, name, intern));
+			if (this->Peek() == hrtds::config::Glyph::END_ARRAY) {
+				this->cursor++;
+				array.SetChildren(std::move(children));
+				return array;
+			}
+
+			this->Expect(hrtds::config::Glyph::LIST_SEPARATOR, "Expected a ',' or ']' after an array element.");
+		}
+	}
+
+	hrtds::Value ProjectedParser::Element(const hrtds::Identifier& identifier, size_t node, const std::string& name, bool intern)
+	{
+		const hrtds::Projection::Node& step = this->nodes[node];
+		if (identifier.GetIdentifierType() != hrtds::IdentifierType::TUPLE) {
+			if (!step.whole) {
+				throw std::invalid_argument("'" + name + "' is neither a tuple nor an array, a path can not continue past it.");
+			}
+
+			return this->Scalar(identifier, intern);
+		}
+
+		// Shared with every other tuple of this struct
+		const std::shared_ptr<const hrtds::TupleLayout>& layout = this->GetLayout(identifier.GetIdentifierName());
+		const std::vector<hrtds::LayoutElement>& layoutElements = layout->layout.GetLayoutElements();
+		const std::vector<size_t>* fieldNodes = step.whole ? nullptr : &this->ElementNodes(node, *layout, name);
+
+		hrtds::Value tuple = hrtds::Value();
+		tuple.SetIdentifier(identifier);
+
+		std::vector<hrtds::Value> children;
+		children.reserve(layoutElements.size());
+
+		this->Expect(hrtds::config::Glyph::BEGIN_TUPLE, "Expected a '(' to begin the tuple.");
+		for (size_t i = 0; i < layoutElements.size(); i++)
+		{
+			if (i != 0 && this->Peek() != hrtds::config::Glyph::LIST_SEPARATOR) {
+				throw std::runtime_error("You need to match the amount of elements in tuple to the layout.");
+			}
+			if (i != 0) this->cursor++;
+
+			const hrtds::LayoutElement& element = layoutElements[i];
+			size_t childNode = fieldNodes != nullptr ? (*fieldNodes)[i] : node;
+			if (childNode == hrtds::Projection::ROOT) {
+				this->cursor = SkipValue(this->content, this->cursor);
+
+				hrtds::Value skipped = hrtds::Value();
+				skipped.SetIdentifier(element.identifier);
+				skipped.SetSkipped(true);
+				children.emplace_back(std::move(skipped));
+				continue;
+			}
+
+			bool internChild = this->pool != nullptr && this->pool->isInternedField(element.name);
+			children.emplace_back(this->Field(element.identifier, childNode, element.name, internChild));
+		}
+
+		if (this->Peek() != hrtds::config::Glyph::END_TUPLE) {
+			throw std::runtime_error("You need to match the amount of elements in tuple to the layout.");
+		}
+		this->cursor++;
+
+		tuple.SetChildren(std::move(children));
+		tuple.SetLayout(layout);
+		return tuple;
+	}
+
+	hrtds::Value ProjectedParser::Scalar(const hrtds::Identifier& identifier, bool intern)
+	{
+		std::string_view scalar;
+		if (this->Peek() == hrtds::config::Glyph::QUOTE) {
+			// Strings keep their whitespace
+			size_t quoteEnd = this->content.find(hrtds::config::Glyph::QUOTE, this->cursor + 1);
+			if (quoteEnd == this->content.npos) {
+				throw std::runtime_error("To define a string you need both an opening quotationmark and a closing one. (Could not find closing quotationmark)");
+			}
+
+			scalar = this->content.substr(this->cursor + 1, quoteEnd - this->cursor - 1);
+			this->cursor = quoteEnd + 1;
+		}
+		else {
+			size_t end = SkipValue(this->content, this->cursor);
+
+			this->text.clear();
+			for (; this->cursor < end; this->cursor++)
+			{
+				if (!isWhitespace(this->content[this->cursor])) {
+					this->text.push_back(this->content[this->cursor]);
+				}
+			}
+
+			scalar = this->text;
+		}
+
+		hrtds::Value value = hrtds::Value();
+		value.SetIdentifier(identifier);
+
+		if (intern && identifier.GetIdentifierName() == "string") {
+			value.SetBorrowed(this->pool->Intern(scalar));
+			return value;
+		}
+
+		value.Set(hrtds::data::DynamicConverter::FromText(identifier.GetIdentifierName(), scalar));
+		return value;
+	}
+
+	char ProjectedParser::Peek()
+	{
+		while (this->cursor < this->content.size() && isWhitespace(this->content[this->cursor]))
+		{
+			this->cursor++;
+		}
+
+		return this->cursor < this->content.size() ? this->content[this->cursor] : '\0';
+	}
+
+	void ProjectedParser::Expect(char glyph, const char* message)
+	{
+		if (this->Peek() != glyph) {
+			throw std::runtime_error(message);
+		}
+
+		this->cursor++;
+	}
+
+	const std::vector<size_t>& ProjectedParser::ElementNodes(size_t node, const hrtds::TupleLayout& layout, const std::string& name)
+	{
+		std::vector<size_t>& resolved = this->elementNodes[node];
+		if (!resolved.empty()) {
+			return resolved;
+		}
+
+		const hrtds::Projection::Node& step = this->nodes[node];
+		if (step.fields.empty()) {
+			throw std::invalid_argument("'" + name + "' is a tuple, select its fields with '.name'.");
+		}
+
+		resolved.assign(layout.layout.GetLayoutElements().size(), hrtds::Projection::ROOT);
+		for (const auto& [field, fieldNode] : step.fields)
+		{
+			auto it = layout.fieldMap.find(field);
+			if (it == layout.fieldMap.end()) {
+				throw std::invalid_argument("'" + name + "' has no field named '" + field + "'.");
+			}
+
+			resolved[it->second] = fieldNode;
+		}
+
+		return resolved;
+	}
+
+	const std::shared_ptr<const hrtds::TupleLayout>& ProjectedParser::GetLayout(const std::string& structure)
+	{
+		std::shared_ptr<const hrtds::TupleLayout>& layout = this->layouts[structure];
+		if (layout != nullptr) {
+			return layout;
+		}
+
+		layout = this->document.GetTupleLayout(structure);
+		if (layout == nullptr) {
+			layout = hrtds::TupleLayout::Create(this->document.GetDeclaredStructures().at(structure));
+		}
+
+		return layout;
+	}
+}
+
+hrtds::Projection::Projection()
+	: nodes(1)
+{}
+
+hrtds::Projection::Projection(std::initializer_list<std::string_view> paths)
+	: Projection()
+{
+	for (std::string_view path : paths)
+	{
+		this->Add(path);
+	}
+}
+
+hrtds::Projection::Projection(const std::vector<std::string>& paths)
+	: Projection()
+{
+	for (const std::string& path : paths)
+	{
+		this->Add(path);
+	}
+}
+
+void hrtds::Projection::Add(std::string_view path)
+{
+	//	windows[*].title
+	//	^^^^^^^				the top-level field
+	//		   ^^^			every element
+	//			  ^^^^^^	a field of the tuple
+	size_t nameEnd = path.find_first_of("[.");
+	size_t node = this->Step(Projection::ROOT, path.substr(0, nameEnd));
+
+	size_t cursor = nameEnd;
+	while (cursor < path.size())
+	{
+		if (path.substr(cursor, 3) == "[*]") {
+			if (this->nodes[node].element == Projection::ROOT) {
+				size_t element = this->nodes.size();
+				this->nodes.emplace_back();
+				this->nodes[node].element = element;
+			}
+
+			node = this->nodes[node].element;
+			cursor += 3;
+			continue;
+		}
+
+		if (path[cursor] != '.') {
+			throw std::invalid_argument("Expected '[*]' or '.name' in the path '" + std::string(path) + "'.");
+		}
+
+		nameEnd = path.find_first_of("[.", cursor + 1);
+		node = this->Step(node, path.substr(cursor + 1, nameEnd == path.npos ? path.npos : nameEnd - cursor - 1));
+		cursor = nameEnd;
+	}
+
+	this->nodes[node].whole = true;
+}
+
+size_t hrtds::Projection::Step(size_t node, std::string_view field)
+{
+	if (field.empty()) {
+		throw std::invalid_argument("A path can not have an empty field name.");
+	}
+
+	auto it = this->nodes[node].fields.find(std::string(field));
+	if (it != this->nodes[node].fields.end()) {
+		return it->second;
+	}
+
+	size_t next = this->nodes.size();
+	this->nodes.emplace_back();
+	this->nodes[node].fields.emplace(std::string(field), next);
+	return next;
+}
+
+const std::vector<hrtds::Projection::Node>& hrtds::Projection::GetNodes() const
+{
+	return this->nodes;
+}
+
+size_t hrtds::Projection::Find(const std::string& name) const
+{
+	const std::unordered_map<std::string, size_t>& fields = this->nodes[Projection::ROOT].fields;
+	auto it = fields.find(name);
+	return it != fields.end() ? it->second : Projection::ROOT;
+}
+
+void hrtds::HRTDS::Parse(HRTDS& hrtds, std::string_view content, const Projection& projection)
+{
+	HRTDS_TRACE_SCOPE("HRTDS::Parse projected", content.size());
+
+	size_t fileScopeBeginPos = content.find(config::GlyphLiterals::BEGIN_FILE_SCOPE);
+	if (fileScopeBeginPos == content.npos) {
+		throw std::runtime_error("The file needs to include a '" + config::GlyphLiterals::BEGIN_FILE_SCOPE + "' to mark the beginning of the file. (The file-begin-marker could not be found)");
+	}
+	fileScopeBeginPos += config::GlyphLiterals::BEGIN_FILE_SCOPE.size();
+
+	size_t fileScopeEndPos = content.rfind(config::GlyphLiterals::END_FILE_SCOPE);
+	if (fileScopeEndPos == content.npos || fileScopeEndPos < fileScopeBeginPos) {
+		throw std::runtime_error("The file needs to include a '" + config::GlyphLiterals::END_FILE_SCOPE + "' to mark the end of the file. (The file-end-marker could not be found)");
+	}
+
+	std::string_view body = content.substr(fileScopeBeginPos, fileScopeEndPos - fileScopeBeginPos);
+
+	// Struct declarations and wholly selected fields are handed to the
+	// regular parser as a document of their own, fields which are partly
+	// selected are parsed by ProjectedParser afterwards
+	std::string selected = config::GlyphLiterals::BEGIN_FILE_SCOPE;
+	std::vector<PendingField> pending;
+	std::vector<std::string> order;
+
+	HRTDS_TRACE_PHASE(phase, "HRTDS::Parse projected scan", body.size());
+
+	size_t cursor = 0;
+	while (true)
+	{
+		while (cursor < body.size() && isWhitespace(body[cursor])) cursor++;
+		if (cursor == body.size()) {
+			break;
+		}
+
+		// &...& ... : ... ;
+		size_t statementBegin = cursor;
+		if (body[cursor] != config::Glyph::IDENTIFIER) {
+			throw std::runtime_error("A field has to begin with an identifier. (Expected a '&')");
+		}
+		cursor++;
+
+		std::string identifierString = ReadUntil(body, cursor, config::Glyph::IDENTIFIER, "An identifier has to be enclosed in '&'s. (Could not find the closing '&')");
+		std::string name = ReadUntil(body, cursor, config::Glyph::ASSIGNMENT, "A field has to be assigned a value. (Could not find the ':')");
+
+		size_t valueBegin = cursor;
+		size_t valueEnd = SkipValue(body, valueBegin);
+		if (valueEnd == body.size() || body[valueEnd] != config::Glyph::TERMINATOR) {
+			throw std::runtime_error("A field has to be terminated. (Could not find the ';')");
+		}
+		cursor = valueEnd + 1;
+
+		if (identifierString == config::IdenifierLiterals::STRUCT_IDENTIFIER) {
+			selected.append(body.substr(statementBegin, cursor - statementBegin));
+			continue;
+		}
+
+		size_t node = projection.Find(name);
+		if (node == Projection::ROOT) {
+			continue;
+		}
+
+		order.push_back(name);
+		if (projection.GetNodes()[node].whole) {
+			selected.append(body.substr(statementBegin, cursor - statementBegin));
+			continue;
+		}
+
+		pending.push_back({ std::move(identifierString), std::move(name), node, valueBegin });
+	}
+
+	selected.append(config::GlyphLiterals::END_FILE_SCOPE);
+
+	HRTDS_TRACE_NEXT(phase, "HRTDS::Parse projected fields", selected.size());
+
+	size_t existingFields = hrtds.GetFieldOrder().size();
+
+	ParseScratch scratch;
+	HRTDS::ParseContent(hrtds, selected, false, scratch);
+
+	if (pending.empty()) {
+		return;
+	}
+
+	ProjectedParser parser(body, projection, hrtds);
+	for (const PendingField& field : pending)
+	{
+		Identifier identifier = field.identifier.empty() ? Identifier(false) : Identifier::Determine(field.identifier, hrtds);
+		if (!identifier.isValid()) {
+			throw std::runtime_error("Unrecognized identifier: '" + field.identifier + "'. If you meant to use a custom struct make sure the name matches and the it's declarations exists before the use of it.");
+		}
+
+		hrtds.DefineField(field.name, parser.Parse(identifier, field.node, field.name, field.begin));
+	}
+
+	// Back in the order of the document, partly selected fields were
+	// defined after all the others
+	std::vector<std::string>& fieldOrder = hrtds.MutableFields().fieldOrder;
+	fieldOrder.resize(existingFields);
+	fieldOrder.insert(fieldOrder.end(), order.begin(), order.end());
+}
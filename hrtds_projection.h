@@ -0,0 +1,54 @@
+#pragma once
+#include <initializer_list>
+#include <string_view>
+#include <unordered_map>
+
+#include ".\hrtds.h"
+
+namespace hrtds {
+	// The parts of a document HRTDS::Parse(.., projection) materializes,
+	// as a set of paths
+	//
+	//	"settings"				the whole top-level field 'settings'
+	//	"windows[*].title"		only 'title' of every tuple in 'windows'
+	//	"windows[*].pos.x"		only 'x' of the 'pos' of every tuple
+	//
+	// A path is a top-level field followed by any number of '[*]' (every
+	// element of an array) and '.name' (a field of a tuple). The paths
+	// form a tree of Nodes, and everything under the last step of a path
+	// is selected as a whole.
+	//
+	//	root --windows--> [*] --title--> (whole)
+	//					   \---pos----> .x (whole)
+	class Projection {
+	public:
+		// A step of one or more paths, 'element' continues into the
+		// elements of an array and 'fields' into the fields of a tuple
+		// (or the top-level fields, for the root)
+		struct Node {
+			bool whole = false;
+			size_t element = 0;
+			std::unordered_map<std::string, size_t> fields;
+		};
+
+		// Nodes are indexed into GetNodes(), 0 is the root (and stands for
+		// "none" as an 'element')
+		static constexpr size_t ROOT = 0;
+
+		Projection();
+		Projection(std::initializer_list<std::string_view> paths);
+		Projection(const std::vector<std::string>& paths);
+
+		// Throws std::invalid_argument for a malformed path
+		void Add(std::string_view path);
+
+		const std::vector<Node>& GetNodes() const;
+
+		// The node of the top-level field 'name', ROOT if it isn't selected
+		size_t Find(const std::string& name) const;
+	private:
+		size_t Step(size_t node, std::string_view field);
+
+		std::vector<Node> nodes;
+	};
+};
@@ -0,0 +1,401 @@
+#include "hrtds_reload.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include ".\hrtds_config.h"
+#include ".\hrtds_utils.h"
+
+namespace {
+	std::string RemoveWhitespace(std::string_view view)
+	{
+		std::string content(view);
+		content.erase(std::remove_if(content.begin(), content.end(), [](char c) { return std::isspace(static_cast<unsigned char>(c)); }), content.end());
+		return content;
+	}
+
+	// "int32_[]" -> "int32_"
+	std::string BaseIdentifierName(std::string_view view)
+	{
+		std::string identifierString = RemoveWhitespace(view);
+		if (!identifierString.empty() && identifierString.back() == hrtds::config::Glyph::END_ARRAY) {
+			identifierString.pop_back();
+			identifierString.pop_back();
+		}
+
+		return identifierString;
+	}
+}
+
+hrtds::Reloader::Reloader(const std::string& path)
+	: path(path)
+{}
+
+hrtds::Reloader::~Reloader()
+{
+	this->Stop();
+}
+
+bool hrtds::Reloader::Reload()
+{
+	std::lock_guard<std::mutex> lock(this->reloadMutex);
+
+	std::ifstream file(this->path, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Could not open '" + this->path + "' for reloading.");
+	}
+
+	std::stringstream stream;
+	stream << file.rdbuf();
+	std::string content = stream.str();
+
+	std::shared_ptr<const HRTDS> previous = this->current.load();
+	if (previous != nullptr && content == this->lastContent) {
+		return false;
+	}
+
+	std::vector<Span> nextSpans = Reloader::Split(content);
+
+	// Every struct declaration which was added, removed or edited. Any
+	// span referencing one of these has to be parsed again.
+	std::unordered_set<std::string_view> nextTexts;
+	for (const Span& span : nextSpans)
+	{
+		nextTexts.insert(span.In(content));
+	}
+
+	std::unordered_set<std::string> dirtyStructures;
+	for (const auto& [text, span] : this->spans)
+	{
+		if (span.structure && !nextTexts.count(text)) {
+			dirtyStructures.insert(span.name);
+		}
+	}
+
+	for (const Span& span : nextSpans)
+	{
+		if (span.structure && !this->spans.count(span.In(content))) {
+			dirtyStructures.insert(span.name);
+		}
+	}
+
+	// Build the next document, reusing whatever we can
+	std::shared_ptr<HRTDS> next = std::make_shared<HRTDS>();
+	for (const Span& span : nextSpans)
+	{
+		std::string_view text = span.In(content);
+		bool reusable = previous != nullptr && this->spans.count(text);
+		for (const std::string& reference : span.references)
+		{
+			if (dirtyStructures.count(reference)) {
+				reusable = false;
+				break;
+			}
+		}
+
+		if (reusable && span.structure) {
+			// Reused fields keep sharing the layout of the previous document
+			std::shared_ptr<const TupleLayout> layout = previous->GetTupleLayout(span.name);
+			if (layout != nullptr) {
+				next->DeclareStructure(span.name, std::move(layout));
+				continue;
+			}
+
+			const auto& declaredStructures = previous->GetDeclaredStructures();
+			auto it = declaredStructures.find(span.name);
+			if (it != declaredStructures.end()) {
+				next->DeclareStructure(span.name, it->second);
+				continue;
+			}
+		}
+
+		// Clones share the children of the previous document's values (see
+		// Value::Clone()), so an unchanged field costs O(1) to carry over
+		if (reusable && !span.structure) {
+			const auto& fields = previous->GetFields();
+			auto it = fields.find(span.name);
+			if (it != fields.end()) {
+				next->DefineField(span.name, it->second.Clone());
+				continue;
+			}
+		}
+
+		if (span.structure) {
+			// Fields using this struct can not be reused either
+			dirtyStructures.insert(span.name);
+		}
+
+		HRTDS::Parse(*next, config::GlyphLiterals::BEGIN_FILE_SCOPE + std::string(text) + config::GlyphLiterals::END_FILE_SCOPE);
+	}
+
+	// Remember what we published, the spans view the content we keep
+	this->lastContent = std::move(content);
+	this->spans.clear();
+	for (Span& span : nextSpans)
+	{
+		std::string_view text = span.In(this->lastContent);
+		this->spans.emplace(text, std::move(span));
+	}
+
+	this->current.store(next);
+
+	ReloadCallback callback;
+	{
+		std::lock_guard<std::mutex> callbackLock(this->callbackMutex);
+		callback = this->reloadCallback;
+	}
+
+	if (callback) {
+		callback(next);
+	}
+
+	return true;
+}
+
+void hrtds::Reloader::Watch()
+{
+	if (this->watching.exchange(true)) {
+		return;
+	}
+
+	if (this->current.load() == nullptr) {
+		try {
+			this->Reload();
+		}
+		catch (...) {
+			this->watching = false;
+			throw;
+		}
+	}
+
+	this->watcher = std::thread(&Reloader::WatchLoop, this);
+}
+
+void hrtds::Reloader::Stop()
+{
+	this->watching = false;
+	if (this->watcher.joinable()) {
+		this->watcher.join();
+	}
+}
+
+bool hrtds::Reloader::isWatching() const
+{
+	return this->watching;
+}
+
+void hrtds::Reloader::SetReloadCallback(ReloadCallback callback)
+{
+	std::lock_guard<std::mutex> lock(this->callbackMutex);
+	this->reloadCallback = callback;
+}
+
+void hrtds::Reloader::SetErrorCallback(ErrorCallback callback)
+{
+	std::lock_guard<std::mutex> lock(this->callbackMutex);
+	this->errorCallback = callback;
+}
+
+std::shared_ptr<const hrtds::HRTDS> hrtds::Reloader::Current() const
+{
+	return this->current.load();
+}
+
+const std::string& hrtds::Reloader::GetPath() const
+{
+	return this->path;
+}
+
+std::string_view hrtds::Reloader::Span::In(std::string_view content) const
+{
+	return content.substr(this->begin, this->length);
+}
+
+std::vector<hrtds::Reloader::Span> hrtds::Reloader::Split(const std::string& content)
+{
+	size_t fileScopeBeginPos = content.find(config::GlyphLiterals::BEGIN_FILE_SCOPE);
+	if (fileScopeBeginPos == content.npos) {
+		throw std::runtime_error("The file needs to include a '" + config::GlyphLiterals::BEGIN_FILE_SCOPE + "' to mark the beginning of the file. (The file-begin-marker could not be found)");
+	}
+	fileScopeBeginPos += config::GlyphLiterals::BEGIN_FILE_SCOPE.size();
+
+	size_t fileScopeEndPos = content.rfind(config::GlyphLiterals::END_FILE_SCOPE);
+	if (fileScopeEndPos == content.npos) {
+		throw std::runtime_error("The file needs to include a '" + config::GlyphLiterals::END_FILE_SCOPE + "' to mark the end of the file. (The file-end-marker could not be found)");
+	}
+
+	std::vector<Span> spans;
+	size_t cursor = fileScopeBeginPos;
+	bool inString = false;
+	for (size_t i = fileScopeBeginPos; i < fileScopeEndPos; i++)
+	{
+		char current = content[i];
+		if (current == config::Glyph::QUOTE) {
+			inString = !inString;
+			continue;
+		}
+
+		if (inString || current != config::Glyph::TERMINATOR) {
+			continue;
+		}
+
+		// Trimmed, the terminator itself is never whitespace
+		Span span;
+		span.begin = cursor;
+		while (std::isspace(static_cast<unsigned char>(content[span.begin])))
+		{
+			span.begin++;
+		}
+
+		span.length = i + 1 - span.begin;
+		cursor = i + 1;
+
+		std::string_view text = span.In(content);
+
+		// [Identifier] (&...&)
+		size_t identifierBegin = text.find(config::Glyph::IDENTIFIER);
+		size_t identifierEnd = text.find(config::Glyph::IDENTIFIER, identifierBegin + 1);
+		if (identifierBegin == text.npos || identifierEnd == text.npos) {
+			throw std::runtime_error("In order to declare the identifier of a field you need to wrap it in two '" + std::string(1, config::Glyph::IDENTIFIER) + "'");
+		}
+
+		std::string identifierString = RemoveWhitespace(text.substr(identifierBegin + 1, (identifierEnd - identifierBegin - 1)));
+		span.structure = identifierString == config::IdenifierLiterals::STRUCT_IDENTIFIER;
+
+		// [Defining] (&...:)
+		size_t definingEnd = text.find(config::Glyph::ASSIGNMENT, identifierEnd + 1);
+		if (definingEnd == text.npos) {
+			throw std::runtime_error("In order to declare the name of a field you need to wrap it in a '" + std::string(1, config::Glyph::IDENTIFIER) + "' and '" + std::string(1, config::Glyph::ASSIGNMENT) + "'");
+		}
+
+		span.name = RemoveWhitespace(text.substr(identifierEnd + 1, (definingEnd - identifierEnd - 1)));
+
+		// A struct depends on the identifiers of its declaring fields,
+		// while a field only depends on its own identifier
+		if (!span.structure) {
+			span.references.push_back(BaseIdentifierName(identifierString));
+		}
+		else {
+			size_t referenceEnd = definingEnd;
+			while (true)
+			{
+				size_t referenceBegin = text.find(config::Glyph::IDENTIFIER, referenceEnd + 1);
+				referenceEnd = text.find(config::Glyph::IDENTIFIER, referenceBegin + 1);
+				if (referenceBegin == text.npos || referenceEnd == text.npos) {
+					break;
+				}
+
+				span.references.push_back(BaseIdentifierName(text.substr(referenceBegin + 1, (referenceEnd - referenceBegin - 1))));
+			}
+		}
+
+		spans.push_back(std::move(span));
+	}
+
+	std::string remainder = content.substr(cursor, (fileScopeEndPos - cursor));
+	utils::Trim(remainder);
+	if (!remainder.empty()) {
+		throw std::runtime_error("Every field needs to be terminated by a '" + std::string(1, config::Glyph::TERMINATOR) + "'. (Found trailing content after the last field)");
+	}
+
+	return spans;
+}
+
+void hrtds::Reloader::WatchLoop()
+{
+	std::filesystem::path file = std::filesystem::absolute(this->path);
+
+#if defined(__linux__)
+	// Editors tend to replace the file rather than write to it, so we
+	// watch the directory and filter on the file name
+	int descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	int watch = descriptor < 0 ? -1 : inotify_add_watch(descriptor, file.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if (watch >= 0) {
+		alignas(inotify_event) char buffer[4096];
+		while (this->watching)
+		{
+			pollfd pollDescriptor = { descriptor, POLLIN, 0 };
+			if (poll(&pollDescriptor, 1, 100) <= 0) {
+				continue;
+			}
+
+			bool changed = false;
+			ssize_t length = 0;
+			while ((length = read(descriptor, buffer, sizeof(buffer))) > 0)
+			{
+				for (char* cursor = buffer; cursor < buffer + length;)
+				{
+					const inotify_event* event = reinterpret_cast<const inotify_event*>(cursor);
+					if (event->len > 0 && file.filename() == event->name) {
+						changed = true;
+					}
+
+					cursor += sizeof(inotify_event) + event->len;
+				}
+			}
+
+			if (!changed) {
+				continue;
+			}
+
+			try {
+				this->Reload();
+			}
+			catch (const std::exception& exception) {
+				this->NotifyError(exception);
+			}
+		}
+
+		close(descriptor);
+		return;
+	}
+
+	if (descriptor >= 0) {
+		close(descriptor);
+	}
+#endif
+
+	// Fall back to polling the modification time
+	std::error_code error;
+	std::filesystem::file_time_type lastWrite = std::filesystem::last_write_time(file, error);
+	while (this->watching)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+		std::filesystem::file_time_type write = std::filesystem::last_write_time(file, error);
+		if (error || write == lastWrite) {
+			continue;
+		}
+
+		lastWrite = write;
+		try {
+			this->Reload();
+		}
+		catch (const std::exception& exception) {
+			this->NotifyError(exception);
+		}
+	}
+}
+
+void hrtds::Reloader::NotifyError(const std::exception& exception)
+{
+	ErrorCallback callback;
+	{
+		std::lock_guard<std::mutex> lock(this->callbackMutex);
+		callback = this->errorCallback;
+	}
+
+	if (callback) {
+		callback(exception);
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include ".\hrtds.h"
+
+namespace hrtds {
+	// Keeps a parsed HRTDS document in sync with a file on disk
+	//
+	//	  <file changes>
+	//		  |
+	//		  |		   <split into top-level spans>
+	//		  \-------[&struct& A : {...};]----> unchanged, reuse layout
+	//		  \-------[&A& a : (...);     ]----> changed, re-parse span
+	//		  \-------[&int32_& b : 2;    ]----> unchanged, reuse value
+	//		  |
+	//		  |		   <publish>
+	//		  \-------> Reloader::Current()
+	//
+	// Only the top-level fields whose text differs from the previous load
+	// are tokenized again, together with any field depending on a struct
+	// declaration that changed. The resulting document is published
+	// atomically, so readers either see the old or the new one.
+	class Reloader {
+	public:
+		typedef std::function<void(std::shared_ptr<const HRTDS>)> ReloadCallback;
+		typedef std::function<void(const std::exception&)> ErrorCallback;
+
+		Reloader(const std::string& path);
+		Reloader(const Reloader& other) = delete;
+		~Reloader();
+
+		Reloader& operator=(const Reloader& other) = delete;
+
+		// Reads the file and publishes a new document if its content
+		// changed. Returns whether anything was published, parsing
+		// errors are thrown and leave the current document in place.
+		bool Reload();
+
+		// Watches the file on a background thread (inotify on Linux,
+		// polling the modification time elsewhere) and calls Reload()
+		// whenever it is written to.
+		void Watch();
+		void Stop();
+		bool isWatching() const;
+
+		void SetReloadCallback(ReloadCallback callback);
+		void SetErrorCallback(ErrorCallback callback);
+
+		std::shared_ptr<const HRTDS> Current() const;
+		const std::string& GetPath() const;
+	private:
+		// One top-level statement: "&identifier& name : value;", as the
+		// range [begin, begin + length) of the content it was split from
+		struct Span {
+			size_t begin = 0;
+			size_t length = 0;
+			std::string name;
+			bool structure = false;
+
+			// Base names of every identifier referenced by the span
+			std::vector<std::string> references;
+
+			std::string_view In(std::string_view content) const;
+		};
+
+		static std::vector<Span> Split(const std::string& content);
+		void WatchLoop();
+		void NotifyError(const std::exception& exception);
+
+		std::string path;
+		std::string lastContent;
+
+		// Spans of the currently published document, keyed by their text
+		// (a view into 'lastContent', which is the only copy kept)
+		std::unordered_map<std::string_view, Span> spans;
+
+		std::atomic<std::shared_ptr<const HRTDS>> current;
+		std::mutex reloadMutex;
+
+		std::mutex callbackMutex;
+		ReloadCallback reloadCallback;
+		ErrorCallback errorCallback;
+
+		std::atomic<bool> watching = false;
+		std::thread watcher;
+	};
+};
\ No newline at end of file
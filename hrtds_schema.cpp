@@ -0,0 +1,59 @@
+#include "hrtds_schema.h"
+
+#include <stdexcept>
+
+hrtds::Schema hrtds::Schema::Parse(std::string_view content)
+{
+	Schema schema;
+	HRTDS::Parse(schema.declarations, std::string(content));
+
+	const std::vector<std::string>& fieldOrder = schema.declarations.GetFieldOrder();
+	if (!fieldOrder.empty()) {
+		throw std::invalid_argument("A schema may only declare structs, but it defines the field '" + fieldOrder.front() + "'.");
+	}
+
+	schema.declarations.MarkSchemaStructures();
+	return schema;
+}
+
+void hrtds::Schema::Declare(const std::string& name, const std::vector<std::pair<std::string, std::string>>& elements)
+{
+	const std::unordered_map<std::string, StructureLayout>& declaredStructures = this->declarations.GetDeclaredStructures();
+	if (declaredStructures.find(name) != declaredStructures.end()) {
+		throw std::invalid_argument("The schema already declares a struct named '" + name + "'.");
+	}
+
+	StructureLayout layout;
+	for (const auto& [identifierString, elementName] : elements)
+	{
+		Identifier identifier = Identifier::Determine(identifierString, this->declarations);
+		if (!identifier.isValid()) {
+			throw std::invalid_argument("Unrecognized identifier: '" + identifierString + "' in the struct '" + name + "'.");
+		}
+
+		layout.AddLayoutElement({ std::move(identifier), elementName });
+	}
+
+	this->declarations.DeclareStructure(name, std::move(layout));
+	this->declarations.MarkSchemaStructures();
+}
+
+std::shared_ptr<const hrtds::TupleLayout> hrtds::Schema::GetTupleLayout(const std::string& name) const
+{
+	return this->declarations.GetTupleLayout(name);
+}
+
+const std::vector<std::string>& hrtds::Schema::GetStructureOrder() const
+{
+	return this->declarations.GetStructureOrder();
+}
+
+size_t hrtds::Schema::size() const
+{
+	return this->declarations.GetStructureOrder().size();
+}
+
+const hrtds::HRTDS& hrtds::Schema::GetDeclarations() const
+{
+	return this->declarations;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <memory>
+#include <string_view>
+#include <utility>
+
+#include ".\hrtds.h"
+
+namespace hrtds {
+	// A set of struct declarations resolved once and shared by every
+	// document parsed with it
+	//
+	//	   schema:	 &struct& Vec2 : {...};  &struct& Window : {...};
+	//					  |						  |
+	//	   message:	 &Window& main : (...);  <----/  (no declarations)
+	//
+	// The layouts (and their TupleLayouts) are created when the schema is
+	// built, parsing a document with it only shares them. A schema is
+	// read-only once built, so one schema can be used by any number of
+	// threads at the same time.
+	class Schema {
+	public:
+		Schema() = default;
+
+		// 'content' is a regular document which only declares structs,
+		// any field in it throws
+		static Schema Parse(std::string_view content);
+
+		// Every element is an identifier and a name, like { "int32_[]", "Scores" }.
+		// Elements may only use built-in types and structs declared before.
+		void Declare(const std::string& name, const std::vector<std::pair<std::string, std::string>>& elements);
+
+		// nullptr if the schema has no struct 'name'
+		std::shared_ptr<const TupleLayout> GetTupleLayout(const std::string& name) const;
+		const std::vector<std::string>& GetStructureOrder() const;
+		size_t size() const;
+
+		// The structs as a document without fields
+		const HRTDS& GetDeclarations() const;
+	private:
+		HRTDS declarations;
+	};
+};
@@ -0,0 +1,332 @@
+#include "hrtds_snapshot.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+	// Every reading thread claims one slot. While it has something pinned
+	// the slot holds the epoch it pinned in, otherwise 0.
+	struct alignas(64) ReaderSlot {
+		std::atomic<uint64_t> epoch = 0;
+		std::atomic<bool> claimed = false;
+		ReaderSlot* next = nullptr;
+	};
+
+	std::atomic<uint64_t> globalEpoch = 1;
+	std::atomic<ReaderSlot*> readerSlots = nullptr;
+
+	ReaderSlot* ClaimSlot()
+	{
+		for (ReaderSlot* slot = readerSlots.load(); slot != nullptr; slot = slot->next)
+		{
+			bool expected = false;
+			if (!slot->claimed.load() && slot->claimed.compare_exchange_strong(expected, true)) {
+				return slot;
+			}
+		}
+
+		// Slots are never freed, they are reused once their thread exits
+		ReaderSlot* slot = new ReaderSlot();
+		slot->claimed = true;
+		slot->next = readerSlots.load();
+		while (!readerSlots.compare_exchange_weak(slot->next, slot));
+
+		return slot;
+	}
+
+	struct ThreadReader {
+		ReaderSlot* slot = nullptr;
+		size_t depth = 0;
+
+		~ThreadReader()
+		{
+			if (this->slot != nullptr) {
+				this->slot->epoch = 0;
+				this->slot->claimed = false;
+			}
+		}
+
+		void Pin()
+		{
+			if (this->depth++ > 0) {
+				return;
+			}
+
+			if (this->slot == nullptr) {
+				this->slot = ClaimSlot();
+			}
+
+			// Has to be visible before we load the current snapshot
+			this->slot->epoch.store(globalEpoch.load());
+		}
+
+		void Unpin()
+		{
+			if (--this->depth == 0) {
+				this->slot->epoch.store(0);
+			}
+		}
+	};
+
+	thread_local ThreadReader threadReader;
+
+	// Destroys retired objects on a background thread once no reader
+	// can reach them anymore
+	class Reclaimer {
+	public:
+		typedef void(*DestroyFunction)(const void*);
+
+		static Reclaimer& Instance()
+		{
+			static Reclaimer reclaimer;
+			return reclaimer;
+		}
+
+		// The object is destroyed once every reader pinned before 'epoch'
+		// has unpinned, an epoch of 0 destroys it on the next pass
+		void Retire(const void* object, DestroyFunction destroy, uint64_t epoch)
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->retired.push_back({ object, destroy, epoch });
+			}
+
+			this->condition.notify_one();
+		}
+
+		void Flush()
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			uint64_t target = ++this->requestedPasses;
+			this->condition.notify_one();
+			this->flushed.wait(lock, [&] { return this->completedPasses >= target && this->retired.empty(); });
+		}
+	private:
+		struct Retired {
+			const void* object;
+			DestroyFunction destroy;
+			uint64_t epoch;
+		};
+
+		Reclaimer()
+			: worker(&Reclaimer::Run, this)
+		{}
+
+		~Reclaimer()
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->stopping = true;
+			}
+
+			this->condition.notify_one();
+			this->worker.join();
+		}
+
+		static uint64_t OldestPinnedEpoch()
+		{
+			uint64_t oldest = std::numeric_limits<uint64_t>::max();
+			for (ReaderSlot* slot = readerSlots.load(); slot != nullptr; slot = slot->next)
+			{
+				uint64_t epoch = slot->epoch.load();
+				if (epoch != 0 && epoch < oldest) {
+					oldest = epoch;
+				}
+			}
+
+			return oldest;
+		}
+
+		void Run()
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			while (true)
+			{
+				if (this->retired.empty() && this->completedPasses == this->requestedPasses) {
+					if (this->stopping) {
+						return;
+					}
+
+					this->condition.wait(lock);
+					continue;
+				}
+
+				uint64_t pass = this->requestedPasses;
+				uint64_t oldest = Reclaimer::OldestPinnedEpoch();
+
+				std::vector<Retired> destroyable;
+				std::vector<Retired> remaining;
+				for (const Retired& retired : this->retired)
+				{
+					(retired.epoch <= oldest ? destroyable : remaining).push_back(retired);
+				}
+				this->retired = std::move(remaining);
+
+				// Destroying may retire more objects, so it has to happen
+				// without holding the lock
+				lock.unlock();
+				for (const Retired& retired : destroyable)
+				{
+					retired.destroy(retired.object);
+				}
+				lock.lock();
+
+				if (destroyable.empty() && !this->retired.empty()) {
+					// Some reader is still pinned, check again shortly
+					this->condition.wait_for(lock, std::chrono::milliseconds(1));
+				}
+
+				if (this->retired.empty()) {
+					this->completedPasses = pass;
+					this->flushed.notify_all();
+				}
+			}
+		}
+
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::condition_variable flushed;
+		std::vector<Retired> retired;
+		uint64_t requestedPasses = 0;
+		uint64_t completedPasses = 0;
+		bool stopping = false;
+
+		std::thread worker;
+	};
+}
+
+namespace hrtds {
+	struct SnapshotDeleter {
+		void operator()(const Snapshot* snapshot) const
+		{
+			Reclaimer::Instance().Retire(snapshot, [](const void* object) {
+				delete reinterpret_cast<const Snapshot*>(object);
+			}, 0);
+		}
+	};
+}
+
+hrtds::Snapshot::Snapshot(HRTDS&& document)
+	: document(std::move(document))
+{}
+
+std::shared_ptr<const hrtds::Snapshot> hrtds::Snapshot::Freeze(HRTDS&& document)
+{
+	return std::shared_ptr<const Snapshot>(new Snapshot(std::move(document)), SnapshotDeleter());
+}
+
+const hrtds::Value& hrtds::Snapshot::operator[](const std::string& name) const
+{
+	return this->document[name];
+}
+
+const hrtds::Value* hrtds::Snapshot::Find(const std::string& name) const
+{
+	const std::unordered_map<std::string, Value>& fields = this->document.GetFields();
+	auto it = fields.find(name);
+	return it != fields.end() ? &it->second : nullptr;
+}
+
+const hrtds::HRTDS& hrtds::Snapshot::GetDocument() const
+{
+	return this->document;
+}
+
+hrtds::HRTDS hrtds::Snapshot::Thaw() const
+{
+	return this->document.Clone();
+}
+
+void hrtds::Snapshot::FlushRetired()
+{
+	Reclaimer::Instance().Flush();
+}
+
+hrtds::SnapshotHolder::ReadGuard::ReadGuard(const std::shared_ptr<const Snapshot>* snapshot)
+	: snapshot(snapshot)
+	, pinned(true)
+{}
+
+hrtds::SnapshotHolder::ReadGuard::ReadGuard(ReadGuard&& other) noexcept
+	: snapshot(std::exchange(other.snapshot, nullptr))
+	, pinned(std::exchange(other.pinned, false))
+{}
+
+hrtds::SnapshotHolder::ReadGuard::~ReadGuard()
+{
+	if (this->pinned) {
+		threadReader.Unpin();
+	}
+}
+
+const hrtds::Snapshot* hrtds::SnapshotHolder::ReadGuard::operator->() const
+{
+	return this->snapshot != nullptr ? this->snapshot->get() : nullptr;
+}
+
+const hrtds::Snapshot& hrtds::SnapshotHolder::ReadGuard::operator*() const
+{
+	return **this->snapshot;
+}
+
+hrtds::SnapshotHolder::ReadGuard::operator bool() const
+{
+	return this->snapshot != nullptr && *this->snapshot != nullptr;
+}
+
+const std::shared_ptr<const hrtds::Snapshot>& hrtds::SnapshotHolder::ReadGuard::GetShared() const
+{
+	static const std::shared_ptr<const Snapshot> empty;
+	return this->snapshot != nullptr ? *this->snapshot : empty;
+}
+
+hrtds::SnapshotHolder::SnapshotHolder(std::shared_ptr<const Snapshot> snapshot)
+{
+	this->Publish(std::move(snapshot));
+}
+
+hrtds::SnapshotHolder::~SnapshotHolder()
+{
+	this->Publish(std::shared_ptr<const Snapshot>());
+}
+
+void hrtds::SnapshotHolder::Publish(std::shared_ptr<const Snapshot> snapshot)
+{
+	const std::shared_ptr<const Snapshot>* next = snapshot != nullptr
+		? new std::shared_ptr<const Snapshot>(std::move(snapshot))
+		: nullptr;
+
+	const std::shared_ptr<const Snapshot>* previous = this->current.exchange(next);
+	if (previous == nullptr) {
+		return;
+	}
+
+	// Readers pinned before this epoch may still be looking at 'previous'
+	uint64_t epoch = globalEpoch.fetch_add(1) + 1;
+	Reclaimer::Instance().Retire(previous, [](const void* object) {
+		delete reinterpret_cast<const std::shared_ptr<const Snapshot>*>(object);
+	}, epoch);
+}
+
+void hrtds::SnapshotHolder::Publish(HRTDS&& document)
+{
+	this->Publish(Snapshot::Freeze(std::move(document)));
+}
+
+hrtds::SnapshotHolder::ReadGuard hrtds::SnapshotHolder::Read() const
+{
+	threadReader.Pin();
+	return ReadGuard(this->current.load());
+}
+
+std::shared_ptr<const hrtds::Snapshot> hrtds::SnapshotHolder::Acquire() const
+{
+	ReadGuard guard = this->Read();
+	return guard.GetShared();
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <memory>
+
+#include ".\hrtds.h"
+
+namespace hrtds {
+	// A frozen, read-only document. Only const access is exposed, which
+	// never copies or mutates anything (see hrtds::Value), so a snapshot
+	// can be read from any number of threads at once.
+	//
+	// Snapshots are only created through Freeze(..), and the last
+	// reference to one does not destroy it in place: the document is
+	// handed to a background thread instead, so the thread dropping it
+	// never pays for tearing down the tree.
+	class Snapshot {
+	public:
+		Snapshot(const Snapshot& other) = delete;
+		Snapshot& operator=(const Snapshot& other) = delete;
+
+		static std::shared_ptr<const Snapshot> Freeze(HRTDS&& document);
+
+		const Value& operator[](const std::string& name) const;
+		const Value* Find(const std::string& name) const;
+		const HRTDS& GetDocument() const;
+
+		// A mutable copy of the document, O(1) (see HRTDS::Clone())
+		HRTDS Thaw() const;
+
+		// Blocks until every snapshot retired so far has been destroyed,
+		// readers which are still pinned delay this
+		static void FlushRetired();
+	private:
+		Snapshot(HRTDS&& document);
+		~Snapshot() = default;
+
+		friend struct SnapshotDeleter;
+
+		HRTDS document;
+	};
+
+	// Holds the current snapshot, RCU style
+	//
+	//	  <reader threads>						<writer thread>
+	//		  |										|
+	//		  |  Read() (pins, no locks)			|  Publish(next)
+	//		  \-------> current <-------------------/
+	//							|
+	//							| <previous>
+	//							\-------> retired until every reader
+	//									  that could see it unpinned,
+	//									  then destroyed in background
+	//
+	// Readers pin the snapshot they see with a ReadGuard. Pinning is a
+	// pair of atomic stores and loads, it never blocks on a writer nor
+	// on other readers.
+	class SnapshotHolder {
+	public:
+		class ReadGuard {
+		public:
+			ReadGuard(ReadGuard&& other) noexcept;
+			ReadGuard(const ReadGuard& other) = delete;
+			~ReadGuard();
+
+			ReadGuard& operator=(ReadGuard&& other) = delete;
+			ReadGuard& operator=(const ReadGuard& other) = delete;
+
+			const Snapshot* operator->() const;
+			const Snapshot& operator*() const;
+			explicit operator bool() const;
+
+			const std::shared_ptr<const Snapshot>& GetShared() const;
+		private:
+			friend class SnapshotHolder;
+			ReadGuard(const std::shared_ptr<const Snapshot>* snapshot);
+
+			const std::shared_ptr<const Snapshot>* snapshot = nullptr;
+			bool pinned = false;
+		};
+
+		SnapshotHolder() = default;
+		SnapshotHolder(std::shared_ptr<const Snapshot> snapshot);
+		SnapshotHolder(const SnapshotHolder& other) = delete;
+		~SnapshotHolder();
+
+		SnapshotHolder& operator=(const SnapshotHolder& other) = delete;
+
+		// Replaces the current snapshot, the previous one is retired
+		void Publish(std::shared_ptr<const Snapshot> snapshot);
+		void Publish(HRTDS&& document);
+
+		// Pins the current snapshot for as long as the guard lives, keep
+		// it short lived. Use Acquire() to hold on to a snapshot.
+		ReadGuard Read() const;
+		std::shared_ptr<const Snapshot> Acquire() const;
+	private:
+		std::atomic<const std::shared_ptr<const Snapshot>*> current = nullptr;
+	};
+};
\ No newline at end of file
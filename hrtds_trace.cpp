@@ -0,0 +1,297 @@
+#include "hrtds_trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+	struct Event {
+		const char* name;
+		uint64_t begin;
+		uint64_t duration;
+		uint64_t size;
+		char detail[hrtds::trace::Span::DETAIL_SIZE];
+	};
+
+	// Events are appended by their thread only. 'count' is published after
+	// the event is written, so Write(..) reads complete events while the
+	// thread keeps recording, and blocks never move once allocated.
+	//
+	//	  ThreadBuffer --> [Block: 4096 events] --> [Block] --> ...
+	//						^ first						^ last
+	struct Block {
+		static constexpr size_t EVENT_COUNT = 4096;
+
+		Event events[Block::EVENT_COUNT];
+		std::atomic<size_t> count = 0;
+		std::atomic<Block*> next = nullptr;
+	};
+
+	struct ThreadBuffer {
+		uint64_t thread = 0;
+		std::unique_ptr<Block> first = std::make_unique<Block>();
+		Block* last = first.get();
+
+		~ThreadBuffer()
+		{
+			this->Reset();
+		}
+
+		// Back to the first block, emptied
+		void Reset()
+		{
+			// Only the first block is owned by the unique_ptr
+			Block* block = this->first->next.exchange(nullptr);
+			while (block != nullptr)
+			{
+				Block* next = block->next.load();
+				delete block;
+				block = next;
+			}
+
+			this->first->count = 0;
+			this->last = this->first.get();
+		}
+	};
+
+	// Buffers are kept after their thread exits, so its spans are still
+	// written out. Registering (once per thread) is the only locking.
+	struct Registry {
+		std::mutex mutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	};
+
+	Registry& GetRegistry()
+	{
+		// Leaked, threads may still record while statics are destroyed
+		static Registry* registry = new Registry();
+		return *registry;
+	}
+
+	ThreadBuffer& LocalBuffer()
+	{
+		thread_local ThreadBuffer* buffer = [] {
+			Registry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			registry.buffers.push_back(std::make_unique<ThreadBuffer>());
+			registry.buffers.back()->thread = registry.buffers.size();
+			return registry.buffers.back().get();
+		}();
+
+		return *buffer;
+	}
+
+	std::atomic<bool> tracing = false;
+
+	const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+	uint64_t Now()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+	}
+
+	void Record(const Event& event)
+	{
+		ThreadBuffer& buffer = LocalBuffer();
+
+		Block* block = buffer.last;
+		size_t count = block->count.load(std::memory_order_relaxed);
+		if (count == Block::EVENT_COUNT) {
+			Block* next = new Block();
+			block->next.store(next, std::memory_order_release);
+			buffer.last = next;
+
+			block = next;
+			count = 0;
+		}
+
+		block->events[count] = event;
+		block->count.store(count + 1, std::memory_order_release);
+	}
+
+	void WriteEscaped(std::ostream& stream, const char* text)
+	{
+		for (; *text != '\0'; text++)
+		{
+			unsigned char character = static_cast<unsigned char>(*text);
+			if (character == '\"' || character == '\\') {
+				stream << '\\' << *text;
+			}
+			else if (character < 0x20) {
+				char escaped[7];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", character);
+				stream << escaped;
+			}
+			else {
+				stream << *text;
+			}
+		}
+	}
+
+	// Nanoseconds as the microseconds Chrome expects
+	void WriteMicroseconds(std::ostream& stream, uint64_t nanoseconds)
+	{
+		stream << nanoseconds / 1000 << '.';
+
+		char fraction[4];
+		std::snprintf(fraction, sizeof(fraction), "%03u", static_cast<unsigned>(nanoseconds % 1000));
+		stream << fraction;
+	}
+}
+
+void hrtds::trace::Enable(bool enabled)
+{
+	tracing.store(enabled, std::memory_order_relaxed);
+}
+
+bool hrtds::trace::isEnabled()
+{
+	return tracing.load(std::memory_order_relaxed);
+}
+
+void hrtds::trace::Clear()
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	for (std::unique_ptr<ThreadBuffer>& buffer : registry.buffers)
+	{
+		buffer->Reset();
+	}
+}
+
+size_t hrtds::trace::size()
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	size_t count = 0;
+	for (const std::unique_ptr<ThreadBuffer>& buffer : registry.buffers)
+	{
+		for (const Block* block = buffer->first.get(); block != nullptr; block = block->next.load(std::memory_order_acquire))
+		{
+			count += block->count.load(std::memory_order_acquire);
+		}
+	}
+
+	return count;
+}
+
+void hrtds::trace::Write(std::ostream& stream)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	//	{"traceEvents": [
+	//		{"name": "Tokenizer::Tokenize", "cat": "hrtds", "ph": "X", "ts": 12.5, "dur": 80.25, "pid": 1, "tid": 1, "args": {"size": 4096}},
+	//		...
+	//	]}
+	stream << "{\"traceEvents\": [";
+
+	bool first = true;
+	for (const std::unique_ptr<ThreadBuffer>& buffer : registry.buffers)
+	{
+		for (const Block* block = buffer->first.get(); block != nullptr; block = block->next.load(std::memory_order_acquire))
+		{
+			size_t count = block->count.load(std::memory_order_acquire);
+			for (size_t i = 0; i < count; i++)
+			{
+				const Event& event = block->events[i];
+
+				stream << (first ? "\n\t" : ",\n\t");
+				stream << "{\"name\": \"";
+				WriteEscaped(stream, event.name);
+				stream << "\", \"cat\": \"hrtds\", \"ph\": \"X\", \"ts\": ";
+				WriteMicroseconds(stream, event.begin);
+				stream << ", \"dur\": ";
+				WriteMicroseconds(stream, event.duration);
+				stream << ", \"pid\": 1, \"tid\": " << buffer->thread;
+				stream << ", \"args\": {\"size\": " << event.size;
+				if (event.detail[0] != '\0') {
+					stream << ", \"detail\": \"";
+					WriteEscaped(stream, event.detail);
+					stream << '\"';
+				}
+				stream << "}}";
+
+				first = false;
+			}
+		}
+	}
+
+	stream << "\n]}\n";
+}
+
+void hrtds::trace::Write(const std::string& path)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		throw std::runtime_error("Could not open '" + path + "' for writing.");
+	}
+
+	trace::Write(file);
+	if (!file) {
+		throw std::runtime_error("Could not write to '" + path + "'.");
+	}
+}
+
+hrtds::trace::Span::Span(const char* name, uint64_t size)
+{
+	if (trace::isEnabled()) {
+		this->name = name;
+		this->size = size;
+		this->begin = Now();
+	}
+}
+
+hrtds::trace::Span::Span(const char* name, uint64_t size, std::string_view detail)
+	: Span(name, size)
+{
+	if (this->name != nullptr) {
+		size_t length = std::min(detail.size(), Span::DETAIL_SIZE - 1);
+		std::memcpy(this->detail, detail.data(), length);
+		this->detail[length] = '\0';
+	}
+}
+
+hrtds::trace::Span::~Span()
+{
+	this->End();
+}
+
+void hrtds::trace::Span::Next(const char* name, uint64_t size)
+{
+	this->End();
+	this->detail[0] = '\0';
+
+	if (trace::isEnabled()) {
+		this->name = name;
+		this->size = size;
+		this->begin = Now();
+	}
+}
+
+void hrtds::trace::Span::End()
+{
+	if (this->name == nullptr) {
+		return;
+	}
+
+	Event event;
+	event.name = this->name;
+	event.begin = this->begin;
+	event.duration = Now() - this->begin;
+	event.size = this->size;
+	std::memcpy(event.detail, this->detail, Span::DETAIL_SIZE);
+
+	Record(event);
+	this->name = nullptr;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace hrtds {
+	// Timed spans around the stages of parsing and composing, written out
+	// as Chrome trace-event JSON (chrome://tracing, Perfetto, ...)
+	//
+	//	|---------------- HRTDS::Parse ----------------|
+	//	|-scope-|--strings--|-ws-|--tokenize--|--fields--|
+	//										  |-Value::Parse "Windows"-|
+	//
+	// Spans are only compiled in when HRTDS_TRACE is defined, otherwise
+	// the HRTDS_TRACE_.. macros expand to nothing (their arguments are not
+	// even evaluated). Compiled in, they are recorded while Enable(true).
+	//
+	// Every thread records into a buffer of its own, appending to it
+	// never locks nor waits on other threads.
+	namespace trace {
+		void Enable(bool enabled);
+		bool isEnabled();
+
+		// Drops every recorded span, nothing may be traced meanwhile
+		void Clear();
+
+		// How many spans have been recorded so far
+		size_t size();
+
+		// Every span recorded so far, as {"traceEvents": [..]}
+		void Write(std::ostream& stream);
+		void Write(const std::string& path);
+
+		// Records the time from its construction to its destruction (or to
+		// Next(..), which starts the following span of a sequence). 'size'
+		// is whatever amount the stage works on, such as bytes or elements,
+		// and 'detail' (like a field name) is cut to DETAIL_SIZE - 1 bytes.
+		class Span {
+		public:
+			Span(const char* name, uint64_t size);
+			Span(const char* name, uint64_t size, std::string_view detail);
+			Span(const Span& other) = delete;
+			~Span();
+
+			Span& operator=(const Span& other) = delete;
+
+			void Next(const char* name, uint64_t size);
+
+			static constexpr size_t DETAIL_SIZE = 48;
+		private:
+			void End();
+
+			const char* name = nullptr;
+			uint64_t size = 0;
+			uint64_t begin = 0;
+			char detail[Span::DETAIL_SIZE] = {};
+		};
+	};
+};
+
+#if defined(HRTDS_TRACE)
+#define HRTDS_TRACE_CONCAT_INNER(a, b) a##b
+#define HRTDS_TRACE_CONCAT(a, b) HRTDS_TRACE_CONCAT_INNER(a, b)
+
+// A span until the end of the enclosing scope
+#define HRTDS_TRACE_SCOPE(name, size) hrtds::trace::Span HRTDS_TRACE_CONCAT(hrtdsTraceSpan, __LINE__)(name, size)
+#define HRTDS_TRACE_SCOPE_DETAIL(name, size, detail) hrtds::trace::Span HRTDS_TRACE_CONCAT(hrtdsTraceSpan, __LINE__)(name, size, detail)
+
+// A sequence of spans, each HRTDS_TRACE_NEXT(..) ends the one before
+#define HRTDS_TRACE_PHASE(span, name, size) hrtds::trace::Span span(name, size)
+#define HRTDS_TRACE_NEXT(span, name, size) span.Next(name, size)
+#else
+#define HRTDS_TRACE_SCOPE(name, size) ((void)0)
+#define HRTDS_TRACE_SCOPE_DETAIL(name, size, detail) ((void)0)
+#define HRTDS_TRACE_PHASE(span, name, size) ((void)0)
+#define HRTDS_TRACE_NEXT(span, name, size) ((void)0)
+#endif
@@ -0,0 +1,537 @@
+#include "hrtds_validator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+#include ".\hrtds_config.h"
+
+namespace {
+	// The strto*(..) call behind a built-in's std::sto*(..), failing where
+	// std::sto*(..) would throw. Saturating into the stored type is left to
+	// the converter, so it is no failure here.
+	template<typename Source, typename Function>
+	bool Converts(const char* text, Function convert)
+	{
+		char* end = nullptr;
+		int saved = errno;
+		errno = 0;
+
+		auto value = convert(text, &end);
+		bool converts = end != text && errno != ERANGE;
+		errno = saved;
+
+		if constexpr (!std::is_same_v<decltype(value), Source>) {
+			converts = converts && value >= std::numeric_limits<Source>::lowest() && value <= std::numeric_limits<Source>::max();
+		}
+
+		return converts;
+	}
+
+	// Checks text the way StaticConverter<T>::FromString(..) converts it,
+	// without allocating the value
+	template<typename T>
+	bool Converts(const char* text)
+	{
+		if constexpr (std::is_same_v<T, int8_t> || std::is_same_v<T, int16_t>) {
+			return Converts<int>(text, [](const char* input, char** end) { return std::strtol(input, end, 10); });
+		}
+		else if constexpr (std::is_same_v<T, int32_t>) {
+			return Converts<long>(text, [](const char* input, char** end) { return std::strtol(input, end, 10); });
+		}
+		else if constexpr (std::is_same_v<T, int64_t>) {
+			return Converts<long long>(text, [](const char* input, char** end) { return std::strtoll(input, end, 10); });
+		}
+		else if constexpr (std::is_same_v<T, uint64_t>) {
+			return Converts<unsigned long long>(text, [](const char* input, char** end) { return std::strtoull(input, end, 10); });
+		}
+		else if constexpr (std::is_unsigned_v<T> && !std::is_same_v<T, bool>) {
+			return Converts<unsigned long>(text, [](const char* input, char** end) { return std::strtoul(input, end, 10); });
+		}
+		else if constexpr (std::is_same_v<T, float>) {
+			return Converts<float>(text, [](const char* input, char** end) { return std::strtof(input, end); });
+		}
+		else if constexpr (std::is_same_v<T, double>) {
+			return Converts<double>(text, [](const char* input, char** end) { return std::strtod(input, end); });
+		}
+		else {
+			// bool and std::string take any text
+			return true;
+		}
+	}
+
+	// An identifier resolved once, so values can be checked without
+	// looking anything up
+	struct ResolvedType {
+		bool array = false;
+
+		// Index into Scanner::layouts for tuples, -1 otherwise
+		int layout = -1;
+
+		// Scalars are checked by converting them through their converter
+		// (into Scanner::storage when they convert in place). Built-ins are
+		// checked by 'check' instead, and strings take any text.
+		bool anything = false;
+		std::string converter;
+		const hrtds::data::InPlaceConverter* inPlace = nullptr;
+		bool (*check)(const char*) = nullptr;
+	};
+
+	class Scanner {
+	public:
+		Scanner(std::string_view content)
+			: content(content)
+		{}
+
+		// Starts out with the structs of 'schema' declared
+		void Adopt(const hrtds::Schema& schema);
+
+		hrtds::ValidationResult Run();
+	private:
+		bool Fail(size_t offset, const char* message);
+
+		void SkipWhitespace();
+		char Peek();
+		bool Expect(char glyph, const char* message);
+
+		// Reads up to (not including) 'stop', returning the text with its
+		// whitespace removed
+		bool ReadUntil(char stop, std::string& text, const char* message);
+
+		bool Resolve(std::string identifierString, size_t offset, ResolvedType& type);
+		ResolvedType Resolve(const hrtds::Identifier& identifier) const;
+
+		bool Structure(const std::string& name);
+		bool Field(const ResolvedType& type);
+		bool Element(const ResolvedType& type);
+		bool Scalar(const ResolvedType& type);
+
+		std::string_view content;
+		size_t cursor = 0;
+		size_t end = 0;
+
+		// Only the declarations are kept around, to resolve identifiers
+		hrtds::HRTDS declarations;
+		std::vector<std::vector<ResolvedType>> layouts;
+		std::unordered_map<std::string, int> layoutIndices;
+
+		// Reused by every scalar converted in place
+		std::vector<unsigned char> storage;
+
+		hrtds::ValidationResult result;
+	};
+
+	hrtds::ValidationResult Scanner::Run()
+	{
+		size_t fileScopeBeginPos = this->content.find(hrtds::config::GlyphLiterals::BEGIN_FILE_SCOPE);
+		if (fileScopeBeginPos == this->content.npos) {
+			this->Fail(0, "The file-begin-marker could not be found.");
+			return this->result;
+		}
+
+		size_t fileScopeEndPos = this->content.rfind(hrtds::config::GlyphLiterals::END_FILE_SCOPE);
+		if (fileScopeEndPos == this->content.npos || fileScopeEndPos < fileScopeBeginPos + hrtds::config::GlyphLiterals::BEGIN_FILE_SCOPE.size()) {
+			this->Fail(this->content.size(), "The file-end-marker could not be found.");
+			return this->result;
+		}
+
+		this->cursor = fileScopeBeginPos + hrtds::config::GlyphLiterals::BEGIN_FILE_SCOPE.size();
+		this->end = fileScopeEndPos;
+
+		std::string identifierString;
+		std::string name;
+		while (this->Peek() != '\0')
+		{
+			// [Identifier] (&...&)
+			if (!this->Expect(hrtds::config::Glyph::IDENTIFIER, "Expected a '&' to begin the identifier of a field.")) break;
+			size_t identifierOffset = this->cursor;
+			if (!this->ReadUntil(hrtds::config::Glyph::IDENTIFIER, identifierString, "Expected a '&' to end the identifier of a field.")) break;
+			this->cursor++;
+
+			// [Defining] (&...:)
+			if (!this->ReadUntil(hrtds::config::Glyph::ASSIGNMENT, name, "Expected a ':' after the name of a field.")) break;
+			this->cursor++;
+
+			// [Value] (:...;)
+			if (identifierString == hrtds::config::IdenifierLiterals::STRUCT_IDENTIFIER) {
+				if (!this->Structure(name)) break;
+			}
+			else {
+				ResolvedType type;
+				if (!this->Resolve(identifierString, identifierOffset, type)) break;
+				if (!this->Field(type)) break;
+			}
+
+			if (!this->Expect(hrtds::config::Glyph::TERMINATOR, "Expected a ';' to terminate the field.")) break;
+		}
+
+		return this->result;
+	}
+
+	bool Scanner::Fail(size_t offset, const char* message)
+	{
+		this->result.valid = false;
+		this->result.offset = offset;
+		this->result.message = message;
+
+		return false;
+	}
+
+	void Scanner::SkipWhitespace()
+	{
+		while (this->cursor < this->end && std::isspace(static_cast<unsigned char>(this->content[this->cursor])))
+		{
+			this->cursor++;
+		}
+	}
+
+	char Scanner::Peek()
+	{
+		this->SkipWhitespace();
+		return this->cursor < this->end ? this->content[this->cursor] : '\0';
+	}
+
+	bool Scanner::Expect(char glyph, const char* message)
+	{
+		if (this->Peek() != glyph) {
+			return this->Fail(this->cursor, message);
+		}
+
+		this->cursor++;
+		return true;
+	}
+
+	bool Scanner::ReadUntil(char stop, std::string& text, const char* message)
+	{
+		text.clear();
+		for (; this->cursor < this->end; this->cursor++)
+		{
+			char current = this->content[this->cursor];
+			if (current == stop) {
+				return true;
+			}
+
+			switch (current)
+			{
+				case hrtds::config::Glyph::IDENTIFIER:
+				case hrtds::config::Glyph::ASSIGNMENT:
+				case hrtds::config::Glyph::TERMINATOR:
+				case hrtds::config::Glyph::QUOTE:
+				case hrtds::config::Glyph::BEGIN_SCOPE:
+				case hrtds::config::Glyph::END_SCOPE:
+				case hrtds::config::Glyph::LIST_SEPARATOR: {
+					return this->Fail(this->cursor, message);
+				}
+				default: break;
+			}
+
+			if (!std::isspace(static_cast<unsigned char>(current))) {
+				text.push_back(current);
+			}
+		}
+
+		return this->Fail(this->cursor, message);
+	}
+
+	bool Scanner::Resolve(std::string identifierString, size_t offset, ResolvedType& type)
+	{
+		if (identifierString.empty()) {
+			return this->Fail(offset, "Unrecognized identifier.");
+		}
+
+		hrtds::Identifier identifier = hrtds::Identifier::Determine(identifierString, this->declarations);
+		if (!identifier.isValid()) {
+			return this->Fail(offset, "Unrecognized identifier.");
+		}
+
+		type = this->Resolve(identifier);
+		return true;
+	}
+
+	ResolvedType Scanner::Resolve(const hrtds::Identifier& identifier) const
+	{
+		ResolvedType type;
+		type.array = identifier.isArray();
+		if (identifier.GetIdentifierType() == hrtds::IdentifierType::TUPLE) {
+			type.layout = this->layoutIndices.at(identifier.GetIdentifierName());
+			return type;
+		}
+
+		type.converter = identifier.GetIdentifierName();
+		type.anything = type.converter == hrtds::data::StaticConverter<std::string>::Alias;
+
+		static const std::unordered_map<std::string, bool (*)(const char*)> builtinChecks = [] {
+			std::unordered_map<std::string, bool (*)(const char*)> checks;
+			hrtds::data::ForEachBuiltin([&](auto builtin) {
+				using T = typename decltype(builtin)::type;
+				checks[hrtds::data::StaticConverter<T>::Alias] = &Converts<T>;
+			});
+
+			return checks;
+		}();
+
+		auto check = builtinChecks.find(type.converter);
+		if (check != builtinChecks.end()) {
+			type.check = check->second;
+			return type;
+		}
+
+		auto inPlace = hrtds::data::DynamicConverter::InPlace.find(type.converter);
+		if (inPlace != hrtds::data::DynamicConverter::InPlace.end()) {
+			type.inPlace = &inPlace->second;
+		}
+
+		return type;
+	}
+
+	void Scanner::Adopt(const hrtds::Schema& schema)
+	{
+		const hrtds::HRTDS& declarations = schema.GetDeclarations();
+		const std::unordered_map<std::string, hrtds::StructureLayout>& declaredStructures = declarations.GetDeclaredStructures();
+		for (const std::string& name : declarations.GetStructureOrder())
+		{
+			const hrtds::StructureLayout& layout = declaredStructures.at(name);
+
+			std::vector<ResolvedType> resolved;
+			for (const hrtds::LayoutElement& element : layout.GetLayoutElements())
+			{
+				resolved.push_back(this->Resolve(element.identifier));
+			}
+
+			this->declarations.DeclareStructure(name, schema.GetTupleLayout(name));
+			this->layoutIndices[name] = static_cast<int>(this->layouts.size());
+			this->layouts.push_back(std::move(resolved));
+		}
+	}
+
+	bool Scanner::Structure(const std::string& name)
+	{
+		//	{ &...& ..., &...& ... }
+		if (!this->Expect(hrtds::config::Glyph::BEGIN_SCOPE, "Expected a '{' to begin the struct declaration.")) return false;
+
+		hrtds::StructureLayout layout;
+		std::vector<ResolvedType> resolved;
+		std::string identifierString;
+		std::string elementName;
+		while (true)
+		{
+			if (!this->Expect(hrtds::config::Glyph::IDENTIFIER, "Expected a '&' to begin the identifier of a declaring field.")) return false;
+			size_t identifierOffset = this->cursor;
+			if (!this->ReadUntil(hrtds::config::Glyph::IDENTIFIER, identifierString, "Expected a '&' to end the identifier of a declaring field.")) return false;
+			this->cursor++;
+
+			// The name runs until the next ',' or '}'
+			elementName.clear();
+			while (this->Peek() != '\0' && this->Peek() != hrtds::config::Glyph::LIST_SEPARATOR && this->Peek() != hrtds::config::Glyph::END_SCOPE)
+			{
+				char current = this->content[this->cursor];
+				if (current == hrtds::config::Glyph::IDENTIFIER || current == hrtds::config::Glyph::TERMINATOR) {
+					return this->Fail(this->cursor, "Expected a ',' or '}' after the name of a declaring field.");
+				}
+
+				elementName.push_back(current);
+				this->cursor++;
+			}
+
+			if (elementName.empty()) {
+				return this->Fail(this->cursor, "Expected the name of a declaring field.");
+			}
+
+			ResolvedType type;
+			if (!this->Resolve(identifierString, identifierOffset, type)) return false;
+
+			layout.AddLayoutElement({ hrtds::Identifier::Determine(identifierString, this->declarations), elementName });
+			resolved.push_back(std::move(type));
+
+			if (this->Peek() == hrtds::config::Glyph::END_SCOPE) {
+				this->cursor++;
+				break;
+			}
+
+			this->cursor++;
+		}
+
+		this->declarations.DeclareStructure(name, std::move(layout));
+		this->layoutIndices[name] = static_cast<int>(this->layouts.size());
+		this->layouts.push_back(std::move(resolved));
+
+		return true;
+	}
+
+	bool Scanner::Field(const ResolvedType& type)
+	{
+		if (!type.array) {
+			return this->Element(type);
+		}
+
+		//	[ ..., ..., ... ]
+		// Like HRTDS::Parse(..), '[]' is read as one empty element, which
+		// only strings accept
+		if (!this->Expect(hrtds::config::Glyph::BEGIN_ARRAY, "Expected a '[' to begin the array.")) return false;
+
+		while (true)
+		{
+			if (!this->Element(type)) return false;
+
+			char next = this->Peek();
+			if (next == hrtds::config::Glyph::END_ARRAY) {
+				this->cursor++;
+				return true;
+			}
+
+			if (!this->Expect(hrtds::config::Glyph::LIST_SEPARATOR, "Expected a ',' or ']' after an array element.")) return false;
+		}
+	}
+
+	bool Scanner::Element(const ResolvedType& type)
+	{
+		if (type.layout < 0) {
+			return this->Scalar(type);
+		}
+
+		//	( ..., ..., ... )
+		const std::vector<ResolvedType>& layout = this->layouts[type.layout];
+		if (!this->Expect(hrtds::config::Glyph::BEGIN_TUPLE, "Expected a '(' to begin the tuple.")) return false;
+
+		for (size_t i = 0; i < layout.size(); i++)
+		{
+			if (i != 0 && this->Peek() == hrtds::config::Glyph::END_TUPLE) {
+				return this->Fail(this->cursor, "The tuple has fewer elements than its layout.");
+			}
+
+			if (i != 0 && !this->Expect(hrtds::config::Glyph::LIST_SEPARATOR, "Expected a ',' between tuple elements.")) return false;
+			if (!this->Field(layout[i])) return false;
+		}
+
+		if (this->Peek() == hrtds::config::Glyph::LIST_SEPARATOR) {
+			return this->Fail(this->cursor, "The tuple has more elements than its layout.");
+		}
+
+		return this->Expect(hrtds::config::Glyph::END_TUPLE, "Expected a ')' to end the tuple.");
+	}
+
+	bool Scanner::Scalar(const ResolvedType& type)
+	{
+		// Scalars are short, only unusually long ones spill to the heap
+		char buffer[256];
+		std::string spilled;
+		size_t length = 0;
+		auto append = [&](char character) {
+			if (length + 1 < sizeof(buffer)) {
+				buffer[length++] = character;
+				return;
+			}
+
+			if (spilled.empty()) {
+				spilled.assign(buffer, length);
+			}
+			spilled.push_back(character);
+			length++;
+		};
+
+		size_t offset = this->cursor;
+		char first = this->Peek();
+		if (first == hrtds::config::Glyph::QUOTE) {
+			// Strings keep their whitespace
+			size_t quoteEnd = this->content.find(hrtds::config::Glyph::QUOTE, this->cursor + 1);
+			if (quoteEnd == this->content.npos || quoteEnd >= this->end) {
+				return this->Fail(this->cursor, "Could not find the closing quotationmark of a string.");
+			}
+
+			for (size_t i = this->cursor + 1; i < quoteEnd; i++)
+			{
+				append(this->content[i]);
+			}
+
+			this->cursor = quoteEnd + 1;
+		}
+		else {
+			for (; this->cursor < this->end; this->cursor++)
+			{
+				char current = this->content[this->cursor];
+				if (current == hrtds::config::Glyph::LIST_SEPARATOR || current == hrtds::config::Glyph::END_TUPLE ||
+					current == hrtds::config::Glyph::END_ARRAY || current == hrtds::config::Glyph::TERMINATOR) {
+					break;
+				}
+
+				switch (current)
+				{
+					case hrtds::config::Glyph::BEGIN_SCOPE:
+					case hrtds::config::Glyph::BEGIN_ARRAY:
+					case hrtds::config::Glyph::BEGIN_TUPLE:
+					case hrtds::config::Glyph::END_SCOPE:
+					case hrtds::config::Glyph::IDENTIFIER:
+					case hrtds::config::Glyph::ASSIGNMENT:
+					case hrtds::config::Glyph::QUOTE: {
+						return this->Fail(this->cursor, "Expected a scalar value.");
+					}
+					default: break;
+				}
+
+				if (!std::isspace(static_cast<unsigned char>(current))) {
+					append(current);
+				}
+			}
+
+			// An empty text is still an (empty) string
+			if (length == 0 && !type.anything) {
+				return this->Fail(offset, "Expected a value.");
+			}
+		}
+
+		buffer[std::min(length, sizeof(buffer) - 1)] = '\0';
+		const char* text = spilled.empty() ? buffer : spilled.c_str();
+
+		bool convertible = false;
+		if (type.anything) {
+			convertible = true;
+		}
+		else if (type.check != nullptr) {
+			convertible = type.check(text);
+		}
+		else if (type.inPlace != nullptr) {
+			const hrtds::data::InPlaceConverter& converter = *type.inPlace;
+			if (this->storage.size() < converter.size + converter.alignment) {
+				this->storage.resize(converter.size + converter.alignment);
+			}
+
+			void* element = this->storage.data();
+			size_t space = this->storage.size();
+			std::align(converter.alignment, converter.size, element, space);
+
+			try {
+				converter.parse(text, element);
+				converter.destruct(element);
+				convertible = true;
+			}
+			catch (...) {}
+		}
+		else {
+			try {
+				void* data = hrtds::data::DynamicConverter::FromString.at(type.converter)(text);
+				hrtds::data::DynamicConverter::Destroy.at(type.converter)(data);
+				convertible = true;
+			}
+			catch (...) {}
+		}
+
+		return convertible ? true : this->Fail(offset, "The value can not be converted to the type of its identifier.");
+	}
+}
+
+hrtds::ValidationResult hrtds::Validator::Validate(std::string_view content)
+{
+	Scanner scanner(content);
+	return scanner.Run();
+}
+
+hrtds::ValidationResult hrtds::Validator::Validate(std::string_view content, const Schema& schema)
+{
+	Scanner scanner(content);
+	scanner.Adopt(schema);
+	return scanner.Run();
+}
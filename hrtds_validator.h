@@ -0,0 +1,39 @@
+#pragma once
+#include <string_view>
+
+#include ".\hrtds.h"
+#include ".\hrtds_schema.h"
+
+namespace hrtds {
+	// The outcome of Validator::Validate(..), on failure 'offset' is the
+	// byte offset into the validated content where the first error was found
+	struct ValidationResult {
+		bool valid = true;
+		size_t offset = 0;
+		const char* message = "";
+
+		explicit operator bool() const { return this->valid; }
+	};
+
+	// Checks a document the way HRTDS::Parse(..) would, without building
+	// it. This covers
+	//	* the syntax of every field and struct declaration,
+	//	* resolving every identifier (through Identifier::Determine(..)),
+	//	* the arity of every tuple against its StructureLayout, and
+	//	* whether every scalar converts to its type.
+	//
+	// Only the struct declarations are kept. Every scalar is accepted
+	// exactly when HRTDS::Parse(..) would accept it: built-ins are checked
+	// with the strto*(..) call their converter makes, without allocating,
+	// custom types are converted through data::DynamicConverter and
+	// destroyed again. Types converted in place (see
+	// HRTDS_DATA_INPLACE_CONVERTER) reuse a single buffer, others are
+	// allocated for the check. Strings take any text.
+	class Validator {
+	public:
+		static ValidationResult Validate(std::string_view content);
+
+		// For documents parsed with HRTDS::Parse(.., schema)
+		static ValidationResult Validate(std::string_view content, const Schema& schema);
+	};
+};
\ No newline at end of file
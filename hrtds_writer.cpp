@@ -0,0 +1,395 @@
+#include "hrtds_writer.h"
+
+#include <stdexcept>
+
+#include ".\hrtds_composer.h"
+#include ".\hrtds_config.h"
+
+hrtds::Writer::Writer(Sink sink, ComposeMode mode)
+	: sink(std::move(sink)), mode(mode)
+{
+	this->buffer.reserve(Writer::BUFFER_SIZE);
+
+	this->Append(config::GlyphLiterals::BEGIN_FILE_SCOPE);
+	if (this->mode == ComposeMode::PRETTY) this->Append(config::Glyph::WHITESPACE_NEWLINE);
+}
+
+hrtds::Writer::Writer(std::ostream& stream, ComposeMode mode)
+	: Writer([&stream](std::string_view text) { stream.write(text.data(), static_cast<std::streamsize>(text.size())); }, mode)
+{}
+
+void hrtds::Writer::DeclareStruct(const std::string& name, const std::vector<std::pair<std::string, std::string>>& elements)
+{
+	if (this->finished || this->inField) {
+		throw std::runtime_error("Structs can only be declared between fields, '" + name + "' is not.");
+	}
+
+	const std::unordered_map<std::string, StructureLayout>& declaredStructures = this->declarations.GetDeclaredStructures();
+	if (declaredStructures.find(name) != declaredStructures.end()) {
+		throw std::invalid_argument("The writer already declared a struct named '" + name + "'.");
+	}
+
+	if (elements.empty()) {
+		throw std::invalid_argument("The struct '" + name + "' needs at least one element.");
+	}
+
+	StructureLayout layout;
+	for (const auto& [identifierString, elementName] : elements)
+	{
+		Identifier identifier = Identifier::Determine(identifierString, this->declarations);
+		if (!identifier.isValid()) {
+			throw std::invalid_argument("Unrecognized identifier: '" + identifierString + "' in the struct '" + name + "'.");
+		}
+
+		layout.AddLayoutElement({ std::move(identifier), elementName });
+	}
+
+	//	&struct& Version : {
+	//		&float& Date,
+	//		&string& Download
+	//	};
+	bool pretty = this->mode == ComposeMode::PRETTY;
+
+	if (pretty) this->Append(config::Glyph::WHITESPACE_TAB);
+	this->Append(config::Glyph::IDENTIFIER);
+	this->Append(config::IdenifierLiterals::STRUCT_IDENTIFIER);
+	this->Append(config::Glyph::IDENTIFIER);
+	if (pretty) this->Append(config::Glyph::WHITESPACE_SPACE);
+	this->Append(name);
+	if (pretty) this->Append(config::Glyph::WHITESPACE_SPACE);
+	this->Append(config::Glyph::ASSIGNMENT);
+	if (pretty) this->Append(config::Glyph::WHITESPACE_SPACE);
+	this->Append(config::Glyph::BEGIN_SCOPE);
+
+	const std::vector<LayoutElement>& layoutElements = layout.GetLayoutElements();
+	for (size_t i = 0; i < layoutElements.size(); i++)
+	{
+		if (pretty) {
+			this->Append(config::Glyph::WHITESPACE_NEWLINE);
+			this->Append(2, config::Glyph::WHITESPACE_TAB);
+		}
+
+		const Identifier& identifier = layoutElements[i].identifier;
+		this->Append(config::Glyph::IDENTIFIER);
+		this->Append(identifier.GetIdentifierName());
+		if (identifier.isArray()) {
+			this->Append(config::Glyph::BEGIN_ARRAY);
+			this->Append(config::Glyph::END_ARRAY);
+		}
+		this->Append(config::Glyph::IDENTIFIER);
+
+		if (pretty) this->Append(config::Glyph::WHITESPACE_SPACE);
+		this->Append(layoutElements[i].name);
+
+		if (i != layoutElements.size() - 1) {
+			this->Append(config::Glyph::LIST_SEPARATOR);
+		}
+	}
+
+	if (pretty) {
+		this->Append(config::Glyph::WHITESPACE_NEWLINE);
+		this->Append(config::Glyph::WHITESPACE_TAB);
+	}
+
+	this->Append(config::Glyph::END_SCOPE);
+	this->Append(config::Glyph::TERMINATOR);
+	if (pretty) this->Append(2, config::Glyph::WHITESPACE_NEWLINE);
+
+	this->declarations.DeclareStructure(name, std::move(layout));
+}
+
+void hrtds::Writer::BeginField(const std::string& identifier, const std::string& name)
+{
+	if (this->finished) {
+		throw std::runtime_error("The writer has already finished, the field '" + name + "' can not be written.");
+	}
+
+	if (this->inField) {
+		throw std::runtime_error("The field '" + name + "' begins before the previous one ended.");
+	}
+
+	Identifier fieldIdentifier = Identifier::Determine(identifier, this->declarations);
+	if (!fieldIdentifier.isValid()) {
+		throw std::invalid_argument("Unrecognized identifier: '" + identifier + "' of the field '" + name + "'.");
+	}
+
+	//	&int32_[]& Version : 
+	bool pretty = this->mode == ComposeMode::PRETTY;
+
+	if (pretty) this->Append(config::Glyph::WHITESPACE_TAB);
+	this->Append(config::Glyph::IDENTIFIER);
+	this->Append(fieldIdentifier.GetIdentifierName());
+	if (fieldIdentifier.isArray()) {
+		this->Append(config::Glyph::BEGIN_ARRAY);
+		this->Append(config::Glyph::END_ARRAY);
+	}
+	this->Append(config::Glyph::IDENTIFIER);
+	if (pretty) this->Append(config::Glyph::WHITESPACE_SPACE);
+	this->Append(name);
+	if (pretty) this->Append(config::Glyph::WHITESPACE_SPACE);
+	this->Append(config::Glyph::ASSIGNMENT);
+	if (pretty) this->Append(config::Glyph::WHITESPACE_SPACE);
+
+	this->fieldIdentifier = std::move(fieldIdentifier);
+	this->fieldWritten = false;
+	this->inField = true;
+}
+
+void hrtds::Writer::EndField()
+{
+	if (!this->inField) {
+		throw std::runtime_error("There is no field to end.");
+	}
+
+	if (!this->frames.empty()) {
+		throw std::runtime_error("The field ends before all of its lists ended.");
+	}
+
+	if (!this->fieldWritten) {
+		throw std::runtime_error("The field ends without a value.");
+	}
+
+	this->Append(config::Glyph::TERMINATOR);
+	if (this->mode == ComposeMode::PRETTY) this->Append(config::Glyph::WHITESPACE_NEWLINE);
+
+	this->inField = false;
+}
+
+void hrtds::Writer::BeginArray()
+{
+	this->BeginList(true);
+}
+
+void hrtds::Writer::EndArray()
+{
+	this->EndList(true);
+}
+
+void hrtds::Writer::BeginTuple()
+{
+	this->BeginList(false);
+}
+
+void hrtds::Writer::EndTuple()
+{
+	this->EndList(false);
+}
+
+void hrtds::Writer::Write(std::string_view string)
+{
+	const Identifier& expected = this->Expect("string");
+	if (expected.isArray() || expected.GetIdentifierName() != "string") {
+		throw std::invalid_argument("Expected a value of type '" + expected.GetIdentifierName() + (expected.isArray() ? "[]" : "") + "', but got a 'string'.");
+	}
+
+	this->Advance();
+	this->Append(config::Glyph::QUOTE);
+	this->Append(string);
+	this->Append(config::Glyph::QUOTE);
+}
+
+void hrtds::Writer::Write(const char* string)
+{
+	this->Write(std::string_view(string));
+}
+
+void hrtds::Writer::Write(const Value& value)
+{
+	int level = this->GetLevel();
+
+	const Identifier& identifier = value.GetIdentifier();
+	const Identifier& expected = this->Expect(identifier.GetIdentifierName().c_str());
+	if (!(expected == identifier) || expected.isArray() != identifier.isArray()) {
+		throw std::invalid_argument("Expected a value of type '" + expected.GetIdentifierName() + (expected.isArray() ? "[]" : "") + "', but got a '" + identifier.GetIdentifierName() + (identifier.isArray() ? "[]" : "") + "'.");
+	}
+
+	// Composed first, so a value which can't be leaves the writer as it was
+	std::string composed = Composer(this->mode).Compose(value, level);
+	this->Advance();
+	this->Append(composed);
+}
+
+void hrtds::Writer::Finish()
+{
+	if (this->finished) {
+		throw std::runtime_error("The writer has already finished.");
+	}
+
+	if (this->inField) {
+		throw std::runtime_error("The writer finishes before the last field ended.");
+	}
+
+	if (this->mode == ComposeMode::PRETTY) this->Append(config::Glyph::WHITESPACE_NEWLINE);
+	this->Append(config::GlyphLiterals::END_FILE_SCOPE);
+
+	this->Flush();
+	this->finished = true;
+}
+
+bool hrtds::Writer::isFinished() const
+{
+	return this->finished;
+}
+
+const hrtds::Identifier& hrtds::Writer::Expect(const char* what) const
+{
+	if (!this->inField) {
+		throw std::runtime_error(std::string("A value (") + what + ") can only be written inside a field.");
+	}
+
+	if (this->frames.empty()) {
+		if (this->fieldWritten) {
+			throw std::runtime_error(std::string("The field already has a value, another (") + what + ") can not be written.");
+		}
+
+		return this->fieldIdentifier;
+	}
+
+	const Frame& frame = this->frames.back();
+	if (frame.layout == nullptr) {
+		return frame.element;
+	}
+
+	const std::vector<LayoutElement>& elements = frame.layout->GetLayoutElements();
+	if (frame.written >= elements.size()) {
+		throw std::runtime_error("You need to match the amount of elements in tuple to the layout.");
+	}
+
+	return elements[frame.written].identifier;
+}
+
+void hrtds::Writer::Advance()
+{
+	if (this->frames.empty()) {
+		this->fieldWritten = true;
+		return;
+	}
+
+	Frame& frame = this->frames.back();
+
+	//	[a, b, c] or, expanded,
+	//	[
+	//		a, 
+	//		b
+	//	]
+	if (frame.written != 0) {
+		this->Append(config::Glyph::LIST_SEPARATOR);
+		if (this->mode == ComposeMode::PRETTY) this->Append(config::Glyph::WHITESPACE_SPACE);
+		if (frame.expand) this->Append(config::Glyph::WHITESPACE_NEWLINE);
+	}
+
+	if (frame.expand) this->Append(static_cast<size_t>(frame.level + 1), config::Glyph::WHITESPACE_TAB);
+
+	frame.written++;
+}
+
+void hrtds::Writer::WriteScalar(const std::string& alias, const std::string& text)
+{
+	const Identifier& expected = this->Expect(alias.c_str());
+	if (expected.isArray() || expected.GetIdentifierType() != IdentifierType::BUILTIN || expected.GetIdentifierName() != alias) {
+		throw std::invalid_argument("Expected a value of type '" + expected.GetIdentifierName() + (expected.isArray() ? "[]" : "") + "', but got a '" + alias + "'.");
+	}
+
+	this->Advance();
+	this->Append(text);
+}
+
+void hrtds::Writer::BeginList(bool array)
+{
+	int level = this->GetLevel();
+
+	const Identifier& expected = this->Expect(array ? "array" : "tuple");
+	if (array != expected.isArray() || (!array && expected.GetIdentifierType() != IdentifierType::TUPLE)) {
+		throw std::invalid_argument("Expected a value of type '" + expected.GetIdentifierName() + (expected.isArray() ? "[]" : "") + "', but got " + (array ? "an array." : "a tuple."));
+	}
+
+	Frame frame;
+	frame.level = level;
+	frame.element = expected;
+	frame.element.SetArray(false);
+	if (!array) {
+		frame.layout = &this->declarations.GetDeclaredStructures().at(expected.GetIdentifierName());
+	}
+	frame.expand = this->Expands(expected, frame.layout);
+
+	this->Advance();
+	this->frames.push_back(std::move(frame));
+
+	this->Append(array ? config::Glyph::BEGIN_ARRAY : config::Glyph::BEGIN_TUPLE);
+	if (this->frames.back().expand) this->Append(config::Glyph::WHITESPACE_NEWLINE);
+}
+
+void hrtds::Writer::EndList(bool array)
+{
+	if (this->frames.empty() || array != (this->frames.back().layout == nullptr)) {
+		throw std::runtime_error(array ? "There is no array to end." : "There is no tuple to end.");
+	}
+
+	Frame& frame = this->frames.back();
+	if (!array && frame.written != frame.layout->GetLayoutElements().size()) {
+		throw std::runtime_error("You need to match the amount of elements in tuple to the layout.");
+	}
+
+	if (frame.expand) {
+		this->Append(config::Glyph::WHITESPACE_NEWLINE);
+		this->Append(static_cast<size_t>(frame.level), config::Glyph::WHITESPACE_TAB);
+	}
+
+	this->Append(array ? config::Glyph::END_ARRAY : config::Glyph::END_TUPLE);
+	this->frames.pop_back();
+}
+
+bool hrtds::Writer::Expands(const Identifier& identifier, const StructureLayout* layout) const
+{
+	if (this->mode != ComposeMode::PRETTY) {
+		return false;
+	}
+
+	// The same rule as Composer, which only depends on the types: arrays
+	// of tuples, and tuples holding other lists, are spread over lines
+	if (identifier.isArray()) {
+		return identifier.GetIdentifierType() == IdentifierType::TUPLE;
+	}
+
+	for (const LayoutElement& element : layout->GetLayoutElements())
+	{
+		if (element.identifier.isArray() || element.identifier.GetIdentifierType() == IdentifierType::TUPLE) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int hrtds::Writer::GetLevel() const
+{
+	return this->frames.empty() ? 1 : this->frames.back().level + 1;
+}
+
+void hrtds::Writer::Append(char character)
+{
+	this->buffer.push_back(character);
+	if (this->buffer.size() >= Writer::BUFFER_SIZE) this->Flush();
+}
+
+void hrtds::Writer::Append(size_t count, char character)
+{
+	this->buffer.append(count, character);
+	if (this->buffer.size() >= Writer::BUFFER_SIZE) this->Flush();
+}
+
+void hrtds::Writer::Append(std::string_view string)
+{
+	this->buffer.append(string);
+	if (this->buffer.size() >= Writer::BUFFER_SIZE) this->Flush();
+}
+
+void hrtds::Writer::Flush()
+{
+	if (this->buffer.empty()) {
+		return;
+	}
+
+	this->sink(this->buffer);
+	this->buffer.clear();
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <functional>
+#include <ostream>
+#include <string_view>
+#include <utility>
+
+#include ".\hrtds.h"
+
+namespace hrtds {
+	// Writes a document straight to a sink while it is being generated,
+	// instead of building the whole Value tree and composing it
+	//
+	//	hrtds::Writer writer(file);
+	//	writer.DeclareStruct("Vec2", { { "int32_", "x" }, { "int32_", "y" } });
+	//	writer.BeginField("Vec2[]", "Points");
+	//	writer.BeginArray();
+	//	for (...) writer.WriteTuple(x, y);
+	//	writer.EndArray();
+	//	writer.EndField();
+	//	writer.Finish();
+	//
+	// Only the struct declarations and the lists currently open are kept,
+	// and the text is handed to the sink in blocks of BUFFER_SIZE, so the
+	// memory used does not grow with the document. Every value is checked
+	// against the type expected where it is written (the field identifier,
+	// the array's element type or the struct's layout), and the output is
+	// the same text Composer would produce for the finished document.
+	class Writer {
+	public:
+		typedef std::function<void(std::string_view)> Sink;
+
+		Writer(Sink sink, ComposeMode mode = ComposeMode::PRETTY);
+		Writer(std::ostream& stream, ComposeMode mode = ComposeMode::PRETTY);
+		Writer(const Writer& other) = delete;
+
+		Writer& operator=(const Writer& other) = delete;
+
+		// Every element is an identifier and a name, like { "int32_[]", "Scores" }
+		void DeclareStruct(const std::string& name, const std::vector<std::pair<std::string, std::string>>& elements);
+
+		// A field takes exactly one value, written between these two
+		void BeginField(const std::string& identifier, const std::string& name);
+		void EndField();
+
+		void BeginArray();
+		void EndArray();
+
+		void BeginTuple();
+		void EndTuple();
+
+		// A scalar of the built-in or custom type T (see data::StaticConverter<T>)
+		template<typename T>
+		void Write(const T& value);
+
+		void Write(std::string_view string);
+		void Write(const char* string);
+
+		// A whole value, composed in one piece
+		void Write(const Value& value);
+
+		// BeginTuple(), Write(..) for every value and EndTuple()
+		template<typename... T>
+		void WriteTuple(const T&... values);
+
+		// Writes the file-end-marker and hands everything left to the sink.
+		// The text is only complete after this.
+		void Finish();
+		bool isFinished() const;
+
+		static constexpr size_t BUFFER_SIZE = 64 * 1024;
+	private:
+		// A list currently being written, 'layout' is set for tuples and
+		// 'element' (the type of every element) for arrays
+		struct Frame {
+			Identifier element;
+			const StructureLayout* layout = nullptr;
+			size_t written = 0;
+			int level = 0;
+			bool expand = false;
+		};
+
+		// The type expected of the next value, throws if no value may be
+		// written here
+		const Identifier& Expect(const char* what) const;
+
+		// Writes whatever goes before the next value
+		void Advance();
+		void WriteScalar(const std::string& alias, const std::string& text);
+		void BeginList(bool array);
+		void EndList(bool array);
+
+		bool Expands(const Identifier& identifier, const StructureLayout* layout) const;
+		int GetLevel() const;
+
+		void Append(char character);
+		void Append(size_t count, char character);
+		void Append(std::string_view string);
+		void Flush();
+
+		Sink sink;
+		ComposeMode mode;
+		std::string buffer;
+
+		// Only the struct declarations, to resolve identifiers
+		HRTDS declarations;
+
+		bool inField = false;
+		bool fieldWritten = false;
+		Identifier fieldIdentifier;
+		std::vector<Frame> frames;
+		bool finished = false;
+	};
+
+	template<typename T>
+	inline void Writer::Write(const T& value)
+	{
+		this->WriteScalar(data::StaticConverter<T>::Alias, data::StaticConverter<T>::ToString(&value));
+	}
+
+	template<typename... T>
+	inline void Writer::WriteTuple(const T&... values)
+	{
+		this->BeginTuple();
+		(this->Write(values), ...);
+		this->EndTuple();
+	}
+};